@@ -0,0 +1,31 @@
+// 全局替换 operator new 以统计合约代码的堆分配
+// 单独成一个编译单元, 避免与容器代码内联后触发 -Wmismatched-new-delete 误报
+#include <cstdlib>
+#include <new>
+
+#include "mock_context.h"
+
+void *operator new(std::size_t size)
+{
+    xchain::bench::AllocStats &stats = xchain::bench::alloc_stats();
+    if (stats.enabled)
+    {
+        stats.count++;
+        stats.bytes += size;
+    }
+    if (void *p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
@@ -0,0 +1,511 @@
+// 合约本地基准驱动: 与任一合约源文件一起编译, 依次调用其全部 DEFINE_METHOD 入口,
+// 输出每个方法的 p50/p99 延迟、每次调用的堆分配次数和账本读写字节数, 最后校验部分查询结果的正确性
+//
+// 用法: contract_bench [每个方法的调用次数, 默认10000]
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "xchain/crypto.h"
+
+#include "json_reader.h"
+#include "json_writer.h"
+#include "mock_context.h"
+
+namespace
+{
+
+const char *const kOwner = "XC1111111111111111@xuper";
+
+// 五个部门全部字段的样例取值, 每个合约只读取自己需要的参数
+const std::map<std::string, std::string> &sampleArgs()
+{
+    static const std::map<std::string, std::string> args = {
+        {"owner", kOwner},
+        {"data", "{\"course\":\"数学\",\"score\":\"95\"}"},
+        // 按版本查询历史记录
+        {"version", "1"},
+        // 按到期日区间查询
+        {"from", "2030-01-01"},
+        {"to", "2040-12-31"},
+        // 按行政区划查询
+        {"code", "北京市/海淀区"},
+        // 按关键词检索
+        {"keywords", "餐饮 管理"},
+        // 工商局
+        {"name", "北京市海淀区中关村餐饮管理有限公司"},
+        {"address", "北京市海淀区中关村大街27号中关村大厦12层1208室"},
+        {"charger", "张伟"},
+        {"businessScope", "餐饮服务；食品销售；餐饮管理；企业管理咨询；会议及展览服务；"
+                          "技术开发、技术咨询、技术服务（依法须经批准的项目，经相关部门批准后依批准的内容开展经营活动）"},
+        {"operatingPeriod", "2021-03-15至2041-03-14"},
+        // 公安局
+        {"sex", "男"},
+        {"nation", "汉族"},
+        {"effectiveDate", "2016.05.20-2036.05.20"},
+        // 国土资源局
+        {"useName", "北京市海淀区中关村科技发展有限公司"},
+        {"landNumber", "京海国用(2021)第00123号"},
+        {"purpose", "城镇住宅用地"},
+        {"serviceLife", "2021-06-01至2091-05-31"},
+        // 城乡规划部
+        {"buildUnite", "北京城建集团有限责任公司"},
+        {"projectname", "海淀区西北旺镇保障性住房项目"},
+        {"buildLocation", "北京市海淀区西北旺镇永丰路东侧"},
+        {"buildScale", "总建筑面积125600.50平方米"},
+        {"issueDate", "2021-08-09"},
+        // 房管局
+        {"preSeller", "北京万科企业有限公司"},
+        {"preArea", "45820.36"},
+        {"projectName", "万科翡翠书院"},
+        {"usualSaleNum", "京房售证字(2021)156号"},
+    };
+    return args;
+}
+
+// 批量接口的样例: kBatchSize 条记录, 每条带上全部样例字段
+const size_t kBatchSize = 10;
+
+std::string sampleRecords()
+{
+    JsonWriter json;
+    json.beginArray();
+    for (size_t i = 0; i < kBatchSize; i++)
+    {
+        char id[32];
+        std::snprintf(id, sizeof(id), "110105198807%06zu", i);
+        json.beginObject();
+        json.field("userid", id);
+        for (const auto &kv : sampleArgs())
+        {
+            json.field(kv.first, kv.second);
+        }
+        json.endObject();
+    }
+    json.endArray();
+    return json.finish();
+}
+
+// 批量查询的样例: 前 kBatchSize-1 个主键来自批量写入, 最后一个不存在
+std::string sampleUserids()
+{
+    JsonWriter json;
+    json.beginArray();
+    for (size_t i = 0; i < kBatchSize; i++)
+    {
+        char id[32];
+        std::snprintf(id, sizeof(id), "110105198807%06zu", i + 1);
+        json.string(id);
+    }
+    json.endArray();
+    return json.finish();
+}
+
+std::string userid(size_t i)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "110105199003%06zu", i);
+    return buf;
+}
+
+bool isInitializer(const std::string &name)
+{
+    static const std::string suffix = "nitialize";
+    return name.size() >= suffix.size() &&
+           name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+double percentile(std::vector<double> samples, double p)
+{
+    if (samples.empty())
+    {
+        return 0;
+    }
+    size_t idx = static_cast<size_t>(p * (samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+    return samples[idx];
+}
+
+struct MethodReport
+{
+    std::string name;
+    size_t calls = 0;
+    size_t failed = 0;
+    std::string lastError;
+    std::vector<double> latencyUs;
+    size_t allocs = 0;
+    size_t allocBytes = 0;
+    size_t bytesRead = 0;
+    size_t bytesWritten = 0;
+};
+
+MethodReport run(xchain::bench::MockContext &ctx, const xchain::bench::Method &method, size_t iterations)
+{
+    using Clock = std::chrono::steady_clock;
+    xchain::bench::AllocStats &alloc = xchain::bench::alloc_stats();
+
+    MethodReport report;
+    report.name = method.name;
+    report.latencyUs.reserve(iterations);
+    std::map<std::string, std::string> args = sampleArgs();
+    args["records"] = sampleRecords();
+    args["userids"] = sampleUserids();
+    for (size_t i = 0; i < iterations; i++)
+    {
+        args["userid"] = userid(i);
+        ctx.begin_call(args, kOwner);
+
+        alloc.count = 0;
+        alloc.bytes = 0;
+        alloc.enabled = true;
+        Clock::time_point start = Clock::now();
+        method.fn();
+        Clock::time_point end = Clock::now();
+        alloc.enabled = false;
+
+        report.calls++;
+        report.latencyUs.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        report.allocs += alloc.count;
+        report.allocBytes += alloc.bytes;
+        report.bytesRead += ctx.call_stats().bytes_read;
+        report.bytesWritten += ctx.call_stats().bytes_written;
+        if (ctx.status() != 200)
+        {
+            report.failed++;
+            report.lastError = ctx.body();
+        }
+    }
+    return report;
+}
+
+const xchain::bench::Method *findMethod(const std::string &name)
+{
+    for (const auto &m : xchain::bench::methods())
+    {
+        if (m.name == name)
+        {
+            return &m;
+        }
+    }
+    return nullptr;
+}
+
+// 以 owner 身份调用一次方法, 失败时输出错误
+bool call(xchain::bench::MockContext &ctx, const xchain::bench::Method &method,
+          const std::map<std::string, std::string> &args)
+{
+    ctx.begin_call(args, kOwner);
+    method.fn();
+    if (ctx.status() != 200)
+    {
+        std::fprintf(stderr, "%s: %s\n", method.name.c_str(), ctx.body().c_str());
+        return false;
+    }
+    return true;
+}
+
+int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+bool fromHex(std::string_view hex, std::string *out)
+{
+    out->clear();
+    if (hex.size() % 2 != 0)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < hex.size(); i += 2)
+    {
+        int hi = hexValue(hex[i]);
+        int lo = hexValue(hex[i + 1]);
+        if (hi < 0 || lo < 0)
+        {
+            return false;
+        }
+        *out += static_cast<char>(hi << 4 | lo);
+    }
+    return true;
+}
+
+// proveRecord 返回的包含证明, 哈希已从十六进制解码
+struct Proof
+{
+    uint64_t index = 0;
+    uint64_t leaves = 0;
+    std::string leaf;
+    std::string root;
+    std::vector<std::string> siblings;
+};
+
+bool parseProof(std::string_view text, Proof *proof)
+{
+    JsonReader in(text);
+    if (!in.beginObject())
+    {
+        return false;
+    }
+    std::string_view key;
+    std::string_view value;
+    std::string buf;
+    std::string keyBuf;
+    while (in.next())
+    {
+        if (!in.key(&key, &keyBuf))
+        {
+            return false;
+        }
+        if (key == "siblings")
+        {
+            if (!in.beginArray())
+            {
+                return false;
+            }
+            while (in.next())
+            {
+                proof->siblings.emplace_back();
+                if (!in.scalar(&value, &buf) || !fromHex(value, &proof->siblings.back()))
+                {
+                    return false;
+                }
+            }
+            continue;
+        }
+        if (!in.scalar(&value, &buf))
+        {
+            return false;
+        }
+        if (key == "index")
+        {
+            proof->index = std::strtoull(std::string(value).c_str(), nullptr, 10);
+        }
+        else if (key == "leaves")
+        {
+            proof->leaves = std::strtoull(std::string(value).c_str(), nullptr, 10);
+        }
+        else if (key == "leaf" && !fromHex(value, &proof->leaf))
+        {
+            return false;
+        }
+        else if (key == "root" && !fromHex(value, &proof->root))
+        {
+            return false;
+        }
+    }
+    return in.finish();
+}
+
+// 由叶子和自下而上的兄弟节点重算根: 编号的第 i 位为1时本节点在第 i 层是右子节点
+std::string rootOf(const Proof &proof)
+{
+    std::string hash = proof.leaf;
+    for (size_t level = 0; level < proof.siblings.size(); level++)
+    {
+        const std::string &sibling = proof.siblings[level];
+        bool right = (proof.index >> level) & 1;
+        hash = xchain::crypto::sha256(std::string(1, '\x01') + (right ? sibling + hash : hash + sibling));
+    }
+    return hash;
+}
+
+// 校验各 query<X>Proof 返回的证明: 叶子等于 sha256(0x00 || query<X> 的返回值), 由叶子和兄弟节点算出的根等于
+// 返回的 root; 基准运行后树中已有多个叶子, 取首尾和中间的记录, 左右子节点的路径都会走到
+bool checkProofs(xchain::bench::MockContext &ctx, size_t iterations)
+{
+    static const std::string prefix = "query";
+    static const std::string suffix = "Proof";
+    bool ok = true;
+    for (const auto &m : xchain::bench::methods())
+    {
+        if (m.name.size() <= prefix.size() + suffix.size() || m.name.compare(0, prefix.size(), prefix) != 0 ||
+            m.name.compare(m.name.size() - suffix.size(), suffix.size(), suffix) != 0)
+        {
+            continue;
+        }
+        const xchain::bench::Method *query = findMethod(m.name.substr(0, m.name.size() - suffix.size()));
+        if (query == nullptr)
+        {
+            continue;
+        }
+        std::map<std::string, std::string> args = sampleArgs();
+        for (size_t i : {size_t(0), iterations / 2, iterations - 1})
+        {
+            args["userid"] = userid(i);
+            if (!call(ctx, m, args))
+            {
+                ok = false;
+                continue;
+            }
+            Proof proof;
+            if (!parseProof(ctx.body(), &proof))
+            {
+                std::fprintf(stderr, "%s: malformed proof %s\n", m.name.c_str(), ctx.body().c_str());
+                ok = false;
+                continue;
+            }
+            if (!call(ctx, *query, args))
+            {
+                ok = false;
+                continue;
+            }
+            const char *error = nullptr;
+            if (proof.leaves < 2 || proof.index >= proof.leaves)
+            {
+                error = "not a multi-leaf proof";
+            }
+            else if (proof.leaf != xchain::crypto::sha256(std::string(1, '\0') + ctx.body()))
+            {
+                error = "leaf does not match the record";
+            }
+            else if (rootOf(proof) != proof.root)
+            {
+                error = "root does not match leaf and siblings";
+            }
+            if (error != nullptr)
+            {
+                std::fprintf(stderr, "%s: %s of %s\n", m.name.c_str(), error, args["userid"].c_str());
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
+
+// 每个部门各有一个可以随意修改的文本字段, 历史校验中每个版本改写它
+const char *const kRevisedFields[] = {"charger", "nation", "useName", "buildUnite", "preSeller"};
+
+// 历史校验写入的版本数, 跨过 KEYFRAME_INTERVAL(16) 个修订一个的完整快照
+const uint64_t kHistoryVersions = 20;
+
+// 校验各 query<X>At 的结果: 对一条新记录用 add<X>/update<X> 写入 kHistoryVersions 个内容各不相同的版本,
+// 每次写入后记下 query<X> 的返回值; 之后按版本号查询, 结果须与当时记下的完全一致
+bool checkHistory(xchain::bench::MockContext &ctx, size_t iterations)
+{
+    static const std::string prefix = "query";
+    static const std::string suffix = "At";
+    bool ok = true;
+    for (const auto &m : xchain::bench::methods())
+    {
+        if (m.name.size() <= prefix.size() + suffix.size() || m.name.compare(0, prefix.size(), prefix) != 0 ||
+            m.name.compare(m.name.size() - suffix.size(), suffix.size(), suffix) != 0)
+        {
+            continue;
+        }
+        std::string agency = m.name.substr(prefix.size(), m.name.size() - prefix.size() - suffix.size());
+        const xchain::bench::Method *add = findMethod("add" + agency);
+        const xchain::bench::Method *update = findMethod("update" + agency);
+        const xchain::bench::Method *query = findMethod("query" + agency);
+        if (add == nullptr || update == nullptr || query == nullptr)
+        {
+            continue;
+        }
+        std::map<std::string, std::string> args = sampleArgs();
+        // 基准只写入了编号小于 iterations 的记录
+        args["userid"] = userid(iterations);
+        std::vector<std::string> expected;
+        for (uint64_t version = 1; version <= kHistoryVersions; version++)
+        {
+            for (const char *field : kRevisedFields)
+            {
+                args[field] = sampleArgs().at(field) + "#" + std::to_string(version);
+            }
+            if (!call(ctx, version == 1 ? *add : *update, args) || !call(ctx, *query, args))
+            {
+                ok = false;
+                break;
+            }
+            expected.push_back(ctx.body());
+        }
+        for (uint64_t version = 1; version <= expected.size(); version++)
+        {
+            args["version"] = std::to_string(version);
+            if (!call(ctx, m, args))
+            {
+                ok = false;
+                continue;
+            }
+            if (ctx.body() != expected[version - 1])
+            {
+                std::fprintf(stderr, "%s: version %llu of %s is %s, written %s\n", m.name.c_str(),
+                             static_cast<unsigned long long>(version), args["userid"].c_str(), ctx.body().c_str(),
+                             expected[version - 1].c_str());
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+    if (iterations == 0)
+    {
+        std::fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    xchain::bench::MockContext ctx;
+    xchain::bench::set_current_context(&ctx);
+
+    // 先执行初始化方法写入owner, 其余方法按定义顺序执行, 保证查询前已有数据
+    std::vector<xchain::bench::Method> ordered;
+    for (const auto &m : xchain::bench::methods())
+    {
+        if (isInitializer(m.name))
+        {
+            ordered.push_back(m);
+        }
+    }
+    for (const auto &m : xchain::bench::methods())
+    {
+        if (!isInitializer(m.name))
+        {
+            ordered.push_back(m);
+        }
+    }
+
+    std::printf("%-36s %8s %7s %10s %10s %9s %11s %10s %10s\n", "method", "calls", "failed",
+                "p50(us)", "p99(us)", "allocs", "alloc(B)", "read(B)", "write(B)");
+    bool ok = true;
+    for (const auto &m : ordered)
+    {
+        MethodReport r = run(ctx, m, iterations);
+        double n = static_cast<double>(r.calls);
+        std::printf("%-36s %8zu %7zu %10.3f %10.3f %9.1f %11.1f %10.1f %10.1f\n", r.name.c_str(), r.calls,
+                    r.failed, percentile(r.latencyUs, 0.50), percentile(r.latencyUs, 0.99), r.allocs / n,
+                    r.allocBytes / n, r.bytesRead / n, r.bytesWritten / n);
+        if (r.failed > 0)
+        {
+            std::fprintf(stderr, "%s: last error: %s\n", r.name.c_str(), r.lastError.c_str());
+            ok = false;
+        }
+    }
+    // 最后校验查询结果本身, 此时账本中已有基准写入的全部记录
+    if (!checkProofs(ctx, iterations))
+    {
+        ok = false;
+    }
+    if (!checkHistory(ctx, iterations))
+    {
+        ok = false;
+    }
+    return ok ? 0 : 2;
+}
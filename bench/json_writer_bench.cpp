@@ -0,0 +1,119 @@
+// JsonWriter 与原 operator+ 拼接写法的对比, 载荷为营业执照的真实中文样例
+//
+// 用法: json_writer_bench [迭代次数, 默认200000]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "json_writer.h"
+#include "mock_context.h"
+
+namespace
+{
+
+struct Business
+{
+    std::string name;
+    std::string address;
+    std::string charger;
+    std::string businessScope;
+    std::string operatingPeriod;
+    std::string userid;
+};
+
+const Business kSample = {
+    "北京市海淀区中关村餐饮管理有限公司",
+    "北京市海淀区中关村大街27号中关村大厦12层1208室",
+    "张伟",
+    "餐饮服务；食品销售；餐饮管理；企业管理咨询；会议及展览服务；"
+    "技术开发、技术咨询、技术服务（依法须经批准的项目，经相关部门批准后依批准的内容开展经营活动）",
+    "2021-03-15至2041-03-14",
+    "110105199003070012",
+};
+
+// 改造前 addBusiness 中的拼接方式
+std::string concat(const Business &b)
+{
+    std::string nameVar = "name";
+    std::string addressVar = "address";
+    std::string chargerVar = "charger";
+    std::string businessScopeVar = "businessScope";
+    std::string operatingPeriodVar = "operatingPeriod";
+    std::string useridVar = "userid";
+    return "{\"" + nameVar + "\":\"" + b.name + "\"," + "\"" + addressVar + "\":\"" + b.address + "\"," + "\"" +
+           chargerVar + "\":\"" + b.charger + "\"," + "\"" + businessScopeVar + "\":\"" + b.businessScope + "\"," +
+           "\"" + operatingPeriodVar + "\":\"" + b.operatingPeriod + "\"," + "\"" + useridVar + "\":\"" + b.userid +
+           "\"}";
+}
+
+std::string writer(const Business &b)
+{
+    size_t size = JsonWriter::kObjectOverhead + JsonWriter::fieldSize("name", b.name) +
+                  JsonWriter::fieldSize("address", b.address) +
+                  JsonWriter::fieldSize("charger", b.charger) +
+                  JsonWriter::fieldSize("businessScope", b.businessScope) +
+                  JsonWriter::fieldSize("operatingPeriod", b.operatingPeriod) +
+                  JsonWriter::fieldSize("userid", b.userid);
+    JsonWriter json(size);
+    json.beginObject();
+    json.field("name", b.name);
+    json.field("address", b.address);
+    json.field("charger", b.charger);
+    json.field("businessScope", b.businessScope);
+    json.field("operatingPeriod", b.operatingPeriod);
+    json.field("userid", b.userid);
+    json.endObject();
+    return json.finish();
+}
+
+template <class Fn>
+void measure(const char *label, const Business &b, size_t iterations, Fn fn)
+{
+    using Clock = std::chrono::steady_clock;
+    xchain::bench::AllocStats &alloc = xchain::bench::alloc_stats();
+    size_t bytes = 0;
+    alloc.count = 0;
+    alloc.bytes = 0;
+    alloc.enabled = true;
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < iterations; i++)
+    {
+        bytes += fn(b).size();
+    }
+    Clock::time_point end = Clock::now();
+    alloc.enabled = false;
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    std::printf("%-22s %10.1f %10.2f %12.1f %10zu\n", label, ns, static_cast<double>(alloc.count) / iterations,
+                static_cast<double>(alloc.bytes) / iterations, bytes / iterations);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    if (iterations == 0)
+    {
+        std::fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    // 不含特殊字符时两种写法的输出必须一致
+    if (concat(kSample) != writer(kSample))
+    {
+        std::fprintf(stderr, "output mismatch:\n%s\n%s\n", concat(kSample).c_str(), writer(kSample).c_str());
+        return 2;
+    }
+
+    Business quoted = kSample;
+    quoted.address = "北京市海淀区\"中关村\"大街27号\\A座";
+
+    std::printf("%-22s %10s %10s %12s %10s\n", "case", "ns/op", "allocs", "alloc(B)", "size(B)");
+    measure("concat", kSample, iterations, concat);
+    measure("writer", kSample, iterations, writer);
+    measure("concat (quoted)", quoted, iterations, concat);
+    measure("writer (quoted)", quoted, iterations, writer);
+    std::printf("\nconcat (quoted): %s\nwriter (quoted): %s\n", concat(quoted).c_str(), writer(quoted).c_str());
+    return 0;
+}
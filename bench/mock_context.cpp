@@ -0,0 +1,173 @@
+#include "mock_context.h"
+
+namespace xchain
+{
+namespace bench
+{
+
+AllocStats &alloc_stats()
+{
+    static AllocStats stats;
+    return stats;
+}
+
+namespace
+{
+Context *g_current = nullptr;
+
+// 按需逐条读取 [start, limit) 区间, 与链上遍历器一样只为实际访问到的条目计费
+class MockIterator : public Iterator
+{
+public:
+    typedef std::map<std::string, std::string>::const_iterator Pos;
+
+    MockIterator(Pos begin, Pos end, const std::string &limit, CallStats *stats)
+        : _next(begin), _end(end), _limit(limit), _stats(stats)
+    {
+    }
+
+    bool next() override
+    {
+        if (_next == _end || _next->first >= _limit)
+        {
+            _valid = false;
+            return false;
+        }
+        _cur = _next++;
+        _valid = true;
+        _stats->reads++;
+        _stats->bytes_read += _cur->first.size() + _cur->second.size();
+        return true;
+    }
+
+    bool get(ElemType *t) override
+    {
+        if (!_valid)
+        {
+            return false;
+        }
+        t->key = _cur->first;
+        t->value = _cur->second;
+        return true;
+    }
+
+private:
+    Pos _next;
+    Pos _end;
+    Pos _cur;
+    std::string _limit;
+    CallStats *_stats;
+    bool _valid = false;
+};
+
+std::vector<Method> &method_table()
+{
+    static std::vector<Method> table;
+    return table;
+}
+} // namespace
+
+Context *current_context()
+{
+    return g_current;
+}
+
+void set_current_context(Context *ctx)
+{
+    g_current = ctx;
+}
+
+void register_method(const char *name, void (*fn)())
+{
+    method_table().push_back(Method{name, fn});
+}
+
+const std::vector<Method> &methods()
+{
+    return method_table();
+}
+
+const std::string &MockContext::arg(const std::string &name) const
+{
+    static const std::string empty;
+    auto it = _args.find(name);
+    if (it == _args.end())
+    {
+        return empty;
+    }
+    return it->second;
+}
+
+bool MockContext::get_object(const std::string &key, std::string *value)
+{
+    _stats.reads++;
+    auto it = _store.find(key);
+    if (it == _store.end())
+    {
+        return false;
+    }
+    // 拷贝到合约提供的缓冲区属于合约的开销, 与链上宿主函数返回数据一致
+    *value = it->second;
+    _stats.bytes_read += key.size() + it->second.size();
+    return true;
+}
+
+bool MockContext::put_object(const std::string &key, const std::string &value)
+{
+    HostScope host;
+    _stats.writes++;
+    _stats.bytes_written += key.size() + value.size();
+    _store[key] = value;
+    return true;
+}
+
+bool MockContext::delete_object(const std::string &key)
+{
+    HostScope host;
+    _stats.writes++;
+    _stats.bytes_written += key.size();
+    return _store.erase(key) > 0;
+}
+
+std::unique_ptr<Iterator> MockContext::new_iterator(const std::string &start,
+                                                    const std::string &limit)
+{
+    HostScope host;
+    return std::unique_ptr<Iterator>(new MockIterator(_store.lower_bound(start), _store.end(), limit, &_stats));
+}
+
+bool MockContext::emit_event(const std::string &name, const std::string &body)
+{
+    HostScope host;
+    _events.emplace_back(name, body);
+    return true;
+}
+
+void MockContext::ok(const std::string &body)
+{
+    HostScope host;
+    _status = 200;
+    _body = body;
+}
+
+void MockContext::error(const std::string &body)
+{
+    HostScope host;
+    _status = 500;
+    _body = body;
+}
+
+void MockContext::begin_call(const std::map<std::string, std::string> &args,
+                             const std::string &initiator)
+{
+    HostScope host;
+    _args = args;
+    _initiator = initiator;
+    _status = 0;
+    _body.clear();
+    _events.clear();
+    _stats = CallStats();
+}
+
+} // namespace bench
+} // namespace xchain
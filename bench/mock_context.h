@@ -0,0 +1,95 @@
+#pragma once
+
+// 进程内的 xchain::Context 实现: 用有序map模拟账本, 并统计每次调用的读写字节与堆分配
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "xchain/xchain.h"
+
+namespace xchain
+{
+namespace bench
+{
+
+// 堆分配计数, 只在 enabled 时累加, 由 alloc_hooks.cpp 中替换的 operator new 维护
+struct AllocStats
+{
+    size_t count = 0;
+    size_t bytes = 0;
+    bool enabled = false;
+};
+AllocStats &alloc_stats();
+
+// 宿主自身的开销(拷贝账本值、保存返回值等)不计入合约的分配次数
+class HostScope
+{
+public:
+    HostScope() : _saved(alloc_stats().enabled) { alloc_stats().enabled = false; }
+    ~HostScope() { alloc_stats().enabled = _saved; }
+
+private:
+    bool _saved;
+};
+
+// 单次调用的账本访问统计
+struct CallStats
+{
+    size_t reads = 0;
+    size_t writes = 0;
+    size_t bytes_read = 0;
+    size_t bytes_written = 0;
+};
+
+class MockContext : public Context
+{
+public:
+    const std::map<std::string, std::string> &args() const override { return _args; }
+    const std::string &arg(const std::string &name) const override;
+    const std::string &initiator() const override { return _initiator; }
+    bool get_object(const std::string &key, std::string *value) override;
+    bool put_object(const std::string &key, const std::string &value) override;
+    bool delete_object(const std::string &key) override;
+    std::unique_ptr<Iterator> new_iterator(const std::string &start,
+                                           const std::string &limit) override;
+    bool emit_event(const std::string &name, const std::string &body) override;
+    void ok(const std::string &body) override;
+    void error(const std::string &body) override;
+
+    // 为下一次调用准备参数与发起者, 并清空上一次的返回值和统计
+    void begin_call(const std::map<std::string, std::string> &args,
+                    const std::string &initiator);
+
+    int status() const { return _status; }
+    const std::string &body() const { return _body; }
+    const CallStats &call_stats() const { return _stats; }
+    const std::map<std::string, std::string> &store() const { return _store; }
+    // 本次调用发出的事件: 名称与内容
+    const std::vector<std::pair<std::string, std::string>> &events() const { return _events; }
+
+private:
+    std::map<std::string, std::string> _args;
+    std::string _initiator;
+    std::map<std::string, std::string> _store;
+    int _status = 0;
+    std::string _body;
+    std::vector<std::pair<std::string, std::string>> _events;
+    CallStats _stats;
+};
+
+// 让后续构造的合约对象绑定到 ctx
+void set_current_context(Context *ctx);
+
+struct Method
+{
+    std::string name;
+    void (*fn)();
+};
+// 按 DEFINE_METHOD 出现顺序登记的全部合约入口
+const std::vector<Method> &methods();
+
+} // namespace bench
+} // namespace xchain
@@ -0,0 +1,252 @@
+// 账本存储体积对比: 改造前的json记录 与 RecordCodec 二进制编码
+// 字段表与 contract/ 下各部门的 Schema 保持一致
+// interned 列为带字典标记的字段引用字典后的记录大小, 字典项由大量记录共享, 不计入
+// 第二张表对比 interned 记录再用 record_dict.h 预置字典压缩后的大小与编解码耗时;
+// 样本记录不在字典的训练样本 tools/dict_samples.txt 中
+// 耗时只是本机原生代码的测量值, 没有在WASM沙箱中测过, 不代表合约执行的CPU时间或gas;
+// +enc/+dec 列为压缩带来的额外耗时; ratio 为1.00x的记录不压缩存储, 但写入时仍要试压缩一次
+//
+// 用法: record_codec_bench [迭代次数, 默认200000]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "json_writer.h"
+#include "record_codec.h"
+
+namespace
+{
+
+struct BusinessSchema
+{
+    static constexpr uint8_t kSchemaId = 1;
+    static constexpr FieldSpec kFields[] = {
+        {"name"},
+        {"address", FieldType::Text, FIELD_INTERNED_PREFIX},
+        {"charger"},
+        {"businessScope", FieldType::Text, FIELD_INTERNED},
+        {"operatingPeriod"},
+    };
+};
+
+struct PoliceSchema
+{
+    static constexpr uint8_t kSchemaId = 2;
+    static constexpr FieldSpec kFields[] = {
+        {"name"}, {"sex"}, {"nation"}, {"address", FieldType::Text, FIELD_INTERNED_PREFIX}, {"effectiveDate"},
+    };
+};
+
+struct LandSchema
+{
+    static constexpr uint8_t kSchemaId = 3;
+    static constexpr FieldSpec kFields[] = {
+        {"useName"},
+        {"address", FieldType::Text, FIELD_INTERNED_PREFIX},
+        {"landNumber"},
+        {"purpose", FieldType::Text, FIELD_INTERNED},
+        {"serviceLife"},
+    };
+};
+
+struct UrbanRuralSchema
+{
+    static constexpr uint8_t kSchemaId = 4;
+    static constexpr FieldSpec kFields[] = {
+        {"buildUnite"},
+        {"projectname"},
+        {"buildLocation", FieldType::Text, FIELD_INTERNED_PREFIX},
+        {"buildScale", FieldType::Decimal},
+        {"issueDate", FieldType::Date},
+    };
+};
+
+struct HousingAuthoritySchema
+{
+    static constexpr uint8_t kSchemaId = 5;
+    static constexpr FieldSpec kFields[] = {
+        {"preSeller"},
+        {"preArea", FieldType::Decimal},
+        {"projectName"},
+        {"usualSaleNum", FieldType::Decimal},
+        {"issueDate", FieldType::Date},
+    };
+};
+
+const char *const kUserid = "110105199003070012";
+
+// 同一 Schema 开启预置字典压缩
+template <class Schema>
+struct Compressed : Schema
+{
+    static constexpr bool kCompressed = true;
+};
+
+// 第二张表的内容, 在第一张表之后输出
+std::string compressionRows;
+
+template <class Schema>
+std::string legacyJson(const typename RecordCodec<Schema>::Values &values)
+{
+    JsonWriter json;
+    json.beginObject();
+    for (size_t i = 0; i < RecordCodec<Schema>::kFieldCount; i++)
+    {
+        json.field(Schema::kFields[i].name, values[i]);
+    }
+    json.field("userid", kUserid);
+    json.endObject();
+    return json.finish();
+}
+
+// 按合约的规则引用字典后的字段部分, 引用取固定字节
+template <class Schema>
+std::string internedFields(const typename RecordCodec<Schema>::Values &values)
+{
+    using Codec = RecordCodec<Schema>;
+    static const std::string kRef(Codec::kRefSize, 'r');
+    typename Codec::Refs refs;
+    for (size_t i = 0; i < Codec::kFieldCount; i++)
+    {
+        unsigned flags = Schema::kFields[i].flags;
+        size_t size = (flags & FIELD_INTERNED) ? values[i].size()
+                      : (flags & FIELD_INTERNED_PREFIX) ? regionPrefixSize(values[i])
+                                                        : 0;
+        if (size >= 16)
+        {
+            refs[i].ref = kRef;
+            refs[i].prefixSize = size;
+        }
+    }
+    return Codec::encodeFields(values, refs);
+}
+
+template <class Codec>
+double encodeNanos(const std::string &fields, size_t iterations, size_t *sink)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++)
+    {
+        *sink += Codec::encode(1, fields).size();
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+template <class Codec>
+double decodeNanos(const std::string &stored, size_t iterations, size_t *sink)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++)
+    {
+        typename Codec::Decoded decoded;
+        Codec::decode(stored, &decoded);
+        *sink += decoded.values[0].size();
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+template <class Schema>
+void measureCompression(const char *label, const typename RecordCodec<Schema>::Values &values, size_t iterations)
+{
+    using Codec = RecordCodec<Schema>;
+    using Packed = RecordCodec<Compressed<Schema>>;
+
+    std::string fields = internedFields<Schema>(values);
+    std::string plain = Codec::encode(1, fields);
+    std::string packed = Packed::encode(1, fields);
+    typename Packed::Decoded check;
+    bool roundTrip = Packed::decode(packed, &check) && check.raw.empty() == (packed.size() == plain.size()) &&
+                     check.values[0] == values[0];
+
+    size_t sink = 0;
+    double enc = encodeNanos<Codec>(fields, iterations, &sink);
+    double encPacked = encodeNanos<Packed>(fields, iterations, &sink);
+    double dec = decodeNanos<Codec>(plain, iterations, &sink);
+    double decPacked = decodeNanos<Packed>(packed, iterations, &sink);
+
+    char row[192];
+    std::snprintf(row, sizeof(row), "%-18s %10zu %13zu %8.2fx %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f %s%s\n",
+                  label, plain.size(), packed.size(), static_cast<double>(plain.size()) / packed.size(), enc,
+                  encPacked, encPacked - enc, dec, decPacked, decPacked - dec, roundTrip ? "ok" : "MISMATCH",
+                  sink == 0 ? " " : "");
+    compressionRows += row;
+}
+
+template <class Schema>
+void measure(const char *label, const typename RecordCodec<Schema>::Values &values, size_t iterations)
+{
+    using Codec = RecordCodec<Schema>;
+    using Clock = std::chrono::steady_clock;
+
+    std::string json = legacyJson<Schema>(values);
+    std::string binary = Codec::encode(values, 1);
+    std::string interned = Codec::encode(1, internedFields<Schema>(values));
+
+    size_t sink = 0;
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < iterations; i++)
+    {
+        sink += Codec::encode(values, 1).size();
+    }
+    Clock::time_point mid = Clock::now();
+    for (size_t i = 0; i < iterations; i++)
+    {
+        typename Codec::Decoded decoded;
+        Codec::decode(binary, &decoded);
+        sink += decoded.values[0].size();
+    }
+    Clock::time_point end = Clock::now();
+
+    typename Codec::Decoded check;
+    bool roundTrip = Codec::decode(binary, &check) && check.values == values;
+    std::printf("%-18s %10zu %10zu %11zu %8.2fx %10.1f %10.1f %s\n", label, json.size(), binary.size(),
+                interned.size(), static_cast<double>(json.size()) / interned.size(),
+                std::chrono::duration<double, std::nano>(mid - start).count() / iterations,
+                std::chrono::duration<double, std::nano>(end - mid).count() / iterations,
+                roundTrip ? "ok" : "MISMATCH");
+    if (sink == 0)
+    {
+        std::printf("\n");
+    }
+    measureCompression<Schema>(label, values, iterations);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    if (iterations == 0)
+    {
+        std::fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("%-18s %10s %10s %11s %9s %10s %10s\n", "record", "json(B)", "binary(B)", "interned(B)", "ratio",
+                "enc(ns)", "dec(ns)");
+    measure<BusinessSchema>("business", {"北京市海淀区中关村餐饮管理有限公司",
+                                         "北京市海淀区中关村大街27号中关村大厦12层1208室", "张伟",
+                                         "餐饮服务；食品销售；餐饮管理；企业管理咨询；会议及展览服务",
+                                         "2021-03-15至2041-03-14"},
+                            iterations);
+    measure<PoliceSchema>("police", {"张伟", "男", "汉族", "北京市海淀区中关村大街27号", "2016.05.20-2036.05.20"},
+                          iterations);
+    measure<LandSchema>("land", {"北京市海淀区中关村科技发展有限公司", "北京市海淀区西北旺镇永丰路东侧",
+                                 "京海国用(2021)第00123号", "城镇住宅用地", "2021-06-01至2091-05-31"},
+                        iterations);
+    measure<UrbanRuralSchema>("urbanRural", {"北京城建集团有限责任公司", "海淀区西北旺镇保障性住房项目",
+                                             "北京市海淀区西北旺镇永丰路东侧", "125600.50", "2021-08-09"},
+                              iterations);
+    measure<HousingAuthoritySchema>("housingAuthority",
+                                    {"北京万科企业有限公司", "45820.36", "万科翡翠书院", "156", "2021-08-09"},
+                                    iterations);
+    // 只有数字和日期的短记录最能体现定点数与日期编码的收益
+    measure<HousingAuthoritySchema>("housing (numeric)", {"万科", "45820.36", "A1", "20210156", "2021-08-09"},
+                                    iterations);
+
+    std::printf("\n%-18s %10s %13s %9s %10s %10s %10s %10s %10s %10s\n", "record", "stored(B)", "compressed(B)",
+                "ratio", "enc(ns)", "enc+z(ns)", "+enc(ns)", "dec(ns)", "dec+z(ns)", "+dec(ns)");
+    std::printf("%s", compressionRows.c_str());
+    return 0;
+}
@@ -0,0 +1,28 @@
+#!/bin/sh
+# 在本机编译并运行全部合约的基准测试, 以及 bench/ 下的各项专项基准
+# 用法: bench/run.sh [每个方法的调用次数]
+set -e
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+OUT="$ROOT/bench/build"
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:-"-std=c++17 -O2 -Wall"}
+HOST="$ROOT/bench/mock_context.cpp $ROOT/bench/mock_crypto.cpp $ROOT/bench/alloc_hooks.cpp"
+mkdir -p "$OUT"
+
+i=0
+for src in "$ROOT"/contract/*.cpp; do
+    i=$((i + 1))
+    bin="$OUT/contract_bench_$i"
+    $CXX $CXXFLAGS -I"$ROOT/bench" -I"$ROOT/contract" -o "$bin" "$src" $HOST "$ROOT/bench/contract_bench.cpp"
+    echo "== $(basename "$src")"
+    "$bin" "$@"
+done
+
+for src in "$ROOT"/bench/*_bench.cpp; do
+    name=$(basename "$src" .cpp)
+    [ "$name" = contract_bench ] && continue
+    $CXX $CXXFLAGS -I"$ROOT/bench" -I"$ROOT/contract" -o "$OUT/$name" "$src" $HOST
+    echo "== $name"
+    "$OUT/$name"
+done
@@ -0,0 +1,15 @@
+#pragma once
+
+// 本地基准测试用的 xchain/crypto.h 替身, 只声明合约代码用到的接口
+#include <string>
+
+namespace xchain
+{
+namespace crypto
+{
+
+// 返回 input 的 SHA-256 摘要(32字节原始值)
+std::string sha256(const std::string &input);
+
+} // namespace crypto
+} // namespace xchain
@@ -0,0 +1,82 @@
+#pragma once
+
+// 本地基准测试用的 xchain 合约SDK替身
+// 只声明合约代码用到的接口子集, 签名与 XuperChain contract-sdk-cpp 保持一致,
+// 使合约源文件无需修改即可在本机编译运行
+#include <map>
+#include <memory>
+#include <string>
+
+namespace xchain
+{
+
+struct Response
+{
+    int status = 0;
+    std::string message;
+    std::string body;
+};
+
+struct ElemType
+{
+    std::string key;
+    std::string value;
+};
+
+// 账本区间遍历器, 由宿主实现
+class Iterator
+{
+public:
+    virtual ~Iterator() {}
+    virtual bool next() = 0;
+    virtual bool get(ElemType *t) = 0;
+};
+
+class Context
+{
+public:
+    virtual ~Context() {}
+    virtual const std::map<std::string, std::string> &args() const = 0;
+    virtual const std::string &arg(const std::string &name) const = 0;
+    virtual const std::string &initiator() const = 0;
+    virtual bool get_object(const std::string &key, std::string *value) = 0;
+    virtual bool put_object(const std::string &key, const std::string &value) = 0;
+    virtual bool delete_object(const std::string &key) = 0;
+    virtual std::unique_ptr<Iterator> new_iterator(const std::string &start,
+                                                   const std::string &limit) = 0;
+    virtual bool emit_event(const std::string &name, const std::string &body) = 0;
+    virtual void ok(const std::string &body) = 0;
+    virtual void error(const std::string &body) = 0;
+};
+
+namespace bench
+{
+// 由本地宿主提供: 当前调用的上下文, 以及合约方法注册表
+Context *current_context();
+void register_method(const char *name, void (*fn)());
+} // namespace bench
+
+class Contract
+{
+public:
+    Contract() : _ctx(bench::current_context()) {}
+    virtual ~Contract() {}
+    Context *context() { return _ctx; }
+
+private:
+    Context *_ctx;
+};
+
+} // namespace xchain
+
+// 与SDK相同地导出 extern "C" 入口, 额外登记到方法表中供基准驱动按名调用
+#define DEFINE_METHOD(contract_class, method_name)                          \
+    static void cxx_##method_name(contract_class &);                        \
+    extern "C" void method_name()                                           \
+    {                                                                       \
+        contract_class t;                                                   \
+        cxx_##method_name(t);                                               \
+    }                                                                       \
+    static const bool registered_##method_name =                            \
+        (::xchain::bench::register_method(#method_name, &method_name), true); \
+    static void cxx_##method_name(contract_class &self)
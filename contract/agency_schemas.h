@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "record_codec.h"
+
+// 各部门存证记录的字段表, 由各部门的单独合约和合并部署的政务服务合约共用
+// kSchemaId 写入每条记录的编码中, 已分配的编号不能修改或复用
+
+// 工商局
+// 营业执照的字段定义, 存储时按此顺序输出, 最后附加主键userid
+struct BusinessSchema
+{
+    static constexpr uint8_t kSchemaId = 1;
+    static constexpr std::string_view kAgency = "business";
+    static constexpr bool kCompressed = true; // 用预置字典压缩存储
+    static constexpr FieldSpec kFields[] = {
+        {"name", FieldType::Text, FIELD_INDEXED | FIELD_SEARCHED},                           // 名称
+        {"address", FieldType::Text, FIELD_INTERNED_PREFIX | FIELD_REGION},                  // 地址
+        {"charger", FieldType::Text, FIELD_INDEXED},                                         // 负责人
+        {"businessScope", FieldType::Text, FIELD_INTERNED | FIELD_GROUPED | FIELD_SEARCHED}, // 经营范围
+        {"operatingPeriod", FieldType::Text, FIELD_EXPIRY},                                  // 经营期限
+    };
+};
+
+// 公安局
+// 身份证的字段定义, 存储时按此顺序输出, 最后附加主键userid
+struct PoliceSchema
+{
+    static constexpr uint8_t kSchemaId = 2;
+    static constexpr std::string_view kAgency = "police";
+    static constexpr bool kCompressed = true; // 用预置字典压缩存储
+    static constexpr FieldSpec kFields[] = {
+        {"name"},                                                           // 姓名
+        {"sex"},                                                            // 性别
+        {"nation"},                                                         // 民族
+        {"address", FieldType::Text, FIELD_INTERNED_PREFIX | FIELD_REGION}, // 地址
+        {"effectiveDate", FieldType::Text, FIELD_EXPIRY},                   // 有效日期
+    };
+};
+
+// 国土资源局
+// 土地使用证的字段定义, 存储时按此顺序输出, 最后附加主键userid
+struct LandSchema
+{
+    static constexpr uint8_t kSchemaId = 3;
+    static constexpr std::string_view kAgency = "land";
+    static constexpr bool kCompressed = true; // 用预置字典压缩存储
+    static constexpr FieldSpec kFields[] = {
+        {"useName"},                                                        // 使用者名称
+        {"address", FieldType::Text, FIELD_INTERNED_PREFIX | FIELD_REGION}, // 地址
+        {"landNumber", FieldType::Text, FIELD_INDEXED},                     // 地号
+        {"purpose", FieldType::Text, FIELD_INTERNED | FIELD_GROUPED},       // 用途
+        {"serviceLife", FieldType::Text, FIELD_EXPIRY},                     // 使用期限
+    };
+};
+
+// 城乡规划部
+// 规划许可证的字段定义, 存储时按此顺序输出, 最后附加主键userid
+struct UrbanRuralSchema
+{
+    static constexpr uint8_t kSchemaId = 4;
+    static constexpr std::string_view kAgency = "urbanRural";
+    static constexpr bool kCompressed = true; // 用预置字典压缩存储
+    static constexpr FieldSpec kFields[] = {
+        {"buildUnite"},                                                           // 建设单位
+        {"projectname"},                                                          // 项目名称
+        {"buildLocation", FieldType::Text, FIELD_INTERNED_PREFIX | FIELD_REGION}, // 建设位置
+        {"buildScale", FieldType::Decimal},                                       // 建设规模
+        {"issueDate", FieldType::Date},                                           // 签发日期
+    };
+};
+
+// 房管局
+// 预售房许可证的字段定义, 存储时按此顺序输出, 最后附加主键userid
+struct HousingAuthoritySchema
+{
+    static constexpr uint8_t kSchemaId = 5;
+    static constexpr std::string_view kAgency = "housingAuthority";
+    static constexpr bool kCompressed = true; // 用预置字典压缩存储
+    static constexpr FieldSpec kFields[] = {
+        {"preSeller"},                                                   // 预售人
+        {"preArea", FieldType::Decimal, FIELD_SUMMED},                   // 预售面积
+        {"projectName", FieldType::Text, FIELD_INDEXED | FIELD_GROUPED}, // 项目名称
+        {"usualSaleNum", FieldType::Decimal},                            // 常房售号
+        {"issueDate", FieldType::Date},                                  // 签发日期
+    };
+};
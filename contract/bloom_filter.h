@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "xchain/xchain.h"
+
+#include "hash.h"
+
+// 账本上的分块布隆过滤器: 每个键的全部位落在同一个分块中, 查询和写入都只访问一个分块
+// 键: B_<分块号>, 分块号为2字节大端整数, 值为 kShardBytes 字节的位图, 不存在的分块全为0
+// 按 kShards * kShardBytes = 1MB 计, 一百万个键时误判率约为2%
+// 只会误判为"可能存在", 不会漏判; 分块在同一次调用内缓存, 批量操作中每个分块只读一次
+class BloomFilter
+{
+public:
+    static constexpr size_t kShards = 16384;
+    static constexpr size_t kShardBytes = 64;
+    static constexpr int kHashes = 5;
+
+    explicit BloomFilter(const std::string &ns) : SHARD_KEY(ns + "B_")
+    {
+    }
+
+    // 加入 key, 位都已置上时不写账本
+    bool add(xchain::Context *ctx, std::string_view key)
+    {
+        Position p = position(key);
+        std::string &shard = loadShard(ctx, p.shard);
+        bool changed = false;
+        for (int i = 0; i < kHashes; i++)
+        {
+            size_t bit = p.bits[i];
+            char mask = static_cast<char>(1 << (bit & 7));
+            if (!(shard[bit >> 3] & mask))
+            {
+                shard[bit >> 3] |= mask;
+                changed = true;
+            }
+        }
+        return !changed || ctx->put_object(shardKey(p.shard), shard);
+    }
+
+    // 返回false时 key 一定没有加入过
+    bool mayContain(xchain::Context *ctx, std::string_view key)
+    {
+        Position p = position(key);
+        const std::string &shard = loadShard(ctx, p.shard);
+        for (int i = 0; i < kHashes; i++)
+        {
+            size_t bit = p.bits[i];
+            if (!(shard[bit >> 3] & (1 << (bit & 7))))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    static constexpr size_t kShardBits = kShardBytes * 8;
+    // 每个哈希占用的位数, 2^kBitsPerHash == kShardBits
+    static constexpr int kBitsPerHash = 9;
+    static_assert(size_t(1) << kBitsPerHash == kShardBits, "kBitsPerHash must match kShardBits");
+    static_assert(kBitsPerHash * kHashes <= 64, "not enough hash bits");
+
+    struct Position
+    {
+        size_t shard;
+        size_t bits[kHashes];
+    };
+
+    // FNV-1a 选分块, 再经 splitmix64 混合后每次取 log2(kShardBits) 位作为块内位置
+    static Position position(std::string_view key)
+    {
+        uint64_t h = fnv1a(key);
+        Position p;
+        p.shard = static_cast<size_t>(h % kShards);
+        uint64_t z = h + 0x9e3779b97f4a7c15ull;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        z ^= z >> 31;
+        for (int i = 0; i < kHashes; i++)
+        {
+            p.bits[i] = static_cast<size_t>(z & (kShardBits - 1));
+            z >>= kBitsPerHash;
+        }
+        return p;
+    }
+
+    std::string shardKey(size_t shard) const
+    {
+        std::string key;
+        key.reserve(SHARD_KEY.size() + 2);
+        key.append(SHARD_KEY);
+        key += static_cast<char>(shard >> 8);
+        key += static_cast<char>(shard & 0xff);
+        return key;
+    }
+
+    std::string &loadShard(xchain::Context *ctx, size_t shard)
+    {
+        auto it = _shards.find(shard);
+        if (it != _shards.end())
+        {
+            return it->second;
+        }
+        std::string value;
+        if (!ctx->get_object(shardKey(shard), &value) || value.size() != kShardBytes)
+        {
+            value.assign(kShardBytes, '\0');
+        }
+        return _shards.emplace(shard, std::move(value)).first->second;
+    }
+
+    const std::string SHARD_KEY;
+    // 本次调用内读过的分块
+    std::map<size_t, std::string> _shards;
+};
@@ -0,0 +1,311 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "xchain/xchain.h"
+
+#include "hash.h"
+#include "json_writer.h"
+#include "varint.h"
+
+// 一次或多次调用对账本的访问计数
+struct CallCounters
+{
+    uint64_t calls = 0;
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+    uint64_t iteratorSteps = 0;
+
+    void add(const CallCounters &other)
+    {
+        calls += other.calls;
+        reads += other.reads;
+        writes += other.writes;
+        bytesRead += other.bytesRead;
+        bytesWritten += other.bytesWritten;
+        iteratorSteps += other.iteratorSteps;
+    }
+
+    // 依次存为 varint
+    std::string encode() const
+    {
+        std::string out;
+        for (uint64_t v : {calls, reads, writes, bytesRead, bytesWritten, iteratorSteps})
+        {
+            Varint::put(&out, v);
+        }
+        return out;
+    }
+
+    bool decode(std::string_view in)
+    {
+        size_t pos = 0;
+        for (uint64_t *v : {&calls, &reads, &writes, &bytesRead, &bytesWritten, &iteratorSteps})
+        {
+            if (!Varint::get(in, &pos, v))
+            {
+                return false;
+            }
+        }
+        return pos == in.size();
+    }
+
+    void writeJson(JsonWriter *json) const
+    {
+        json->key("calls");
+        json->number(calls);
+        json->key("reads");
+        json->number(reads);
+        json->key("writes");
+        json->number(writes);
+        json->key("bytesRead");
+        json->number(bytesRead);
+        json->key("bytesWritten");
+        json->number(bytesWritten);
+        json->key("iteratorSteps");
+        json->number(iteratorSteps);
+    }
+};
+
+// 转发到宿主上下文并统计账本访问, 读写字节数按键和值的长度之和计
+// 遍历器每次 next() 计一步, 取到的条目计入读取字节数
+class MeteredContext : public xchain::Context
+{
+public:
+    explicit MeteredContext(xchain::Context *inner) : _inner(inner)
+    {
+    }
+
+    xchain::Context *inner()
+    {
+        return _inner;
+    }
+
+    CallCounters &counters()
+    {
+        return _counters;
+    }
+
+    const std::map<std::string, std::string> &args() const override
+    {
+        return _inner->args();
+    }
+
+    const std::string &arg(const std::string &name) const override
+    {
+        return _inner->arg(name);
+    }
+
+    const std::string &initiator() const override
+    {
+        return _inner->initiator();
+    }
+
+    bool get_object(const std::string &key, std::string *value) override
+    {
+        _counters.reads++;
+        if (!_inner->get_object(key, value))
+        {
+            return false;
+        }
+        _counters.bytesRead += key.size() + value->size();
+        return true;
+    }
+
+    bool put_object(const std::string &key, const std::string &value) override
+    {
+        _counters.writes++;
+        _counters.bytesWritten += key.size() + value.size();
+        return _inner->put_object(key, value);
+    }
+
+    bool delete_object(const std::string &key) override
+    {
+        _counters.writes++;
+        _counters.bytesWritten += key.size();
+        return _inner->delete_object(key);
+    }
+
+    std::unique_ptr<xchain::Iterator> new_iterator(const std::string &start, const std::string &limit) override
+    {
+        return std::unique_ptr<xchain::Iterator>(new MeteredIterator(_inner->new_iterator(start, limit), &_counters));
+    }
+
+    bool emit_event(const std::string &name, const std::string &body) override
+    {
+        return _inner->emit_event(name, body);
+    }
+
+    void ok(const std::string &body) override
+    {
+        _inner->ok(body);
+    }
+
+    void error(const std::string &body) override
+    {
+        _inner->error(body);
+    }
+
+private:
+    class MeteredIterator : public xchain::Iterator
+    {
+    public:
+        MeteredIterator(std::unique_ptr<xchain::Iterator> inner, CallCounters *counters)
+            : _inner(std::move(inner)), _counters(counters)
+        {
+        }
+
+        bool next() override
+        {
+            _counters->iteratorSteps++;
+            return _inner->next();
+        }
+
+        bool get(xchain::ElemType *t) override
+        {
+            if (!_inner->get(t))
+            {
+                return false;
+            }
+            _counters->bytesRead += t->key.size() + t->value.size();
+            return true;
+        }
+
+    private:
+        std::unique_ptr<xchain::Iterator> _inner;
+        CallCounters *_counters;
+    };
+
+    xchain::Context *_inner;
+    CallCounters _counters;
+};
+
+// 按入口方法统计资源消耗: 在方法入口构造, 析构时处理本次调用的计数
+// 参数 stats 为true时发出名为 "stats" 的事件, 内容为本次调用的计数; 没有这个参数时不做任何额外的账本访问
+// 同时若本次调用写了账本, 再把计数累加到 S_<方法>\0<分块>; 只读的调用(包括作为交易提交的查询)从不写统计键
+// 写入方法只有各部门的owner能调用, 按发起者分块起不到分散作用, 因此按调用参数的哈希选分块,
+// 不同记录的写入大多落在不同的键上, 不会因统计而互相冲突; 统计键自身的读写不计入
+// 累计值只覆盖带了 stats 参数的写入调用, 相当于由调用方抽样
+class CallMeter
+{
+public:
+    // 统计键不带命名空间前缀, 有意由合约内各部门共用: 键中是合约入口方法名, 在一个合约内各不相同,
+    // 如政务服务中的 addBusiness 与 addLand, 不会混在一起; queryStats 因而一次列出整个合约的统计
+    static constexpr std::string_view STATS_KEY = "S_";
+    static constexpr size_t kStatsShards = 16;
+
+    // method 为合约的入口方法名, 如 addBusiness
+    CallMeter(MeteredContext *ctx, std::string method) : _ctx(ctx), _method(std::move(method))
+    {
+        _ctx->counters() = CallCounters();
+    }
+
+    ~CallMeter()
+    {
+        xchain::Context *host = _ctx->inner();
+        const std::string &flag = host->arg("stats");
+        if (flag != "true" && flag != "1")
+        {
+            return;
+        }
+        CallCounters call = _ctx->counters();
+        call.calls = 1;
+        JsonWriter json(160 + _method.size());
+        json.beginObject();
+        json.field("method", _method);
+        call.writeJson(&json);
+        json.endObject();
+        host->emit_event("stats", json.finish());
+
+        if (call.writes == 0)
+        {
+            return;
+        }
+        std::string key = statsKey(host);
+        CallCounters total;
+        std::string stored;
+        if (host->get_object(key, &stored) && !total.decode(stored))
+        {
+            total = CallCounters();
+        }
+        total.add(call);
+        host->put_object(key, total.encode());
+    }
+
+    CallMeter(const CallMeter &) = delete;
+    CallMeter &operator=(const CallMeter &) = delete;
+
+    // 列出全部方法的累计计数: {"stats":[{"method":"..","calls":n,...},...]}, 按方法名排序, 各分块合并输出
+    static void queryStats(xchain::Context *ctx)
+    {
+        std::string start(STATS_KEY);
+        std::string limit = start;
+        limit.back()++;
+        std::unique_ptr<xchain::Iterator> it = ctx->new_iterator(start, limit);
+        std::map<std::string, CallCounters, std::less<>> totals;
+        xchain::ElemType elem;
+        while (it->next())
+        {
+            CallCounters shard;
+            if (!it->get(&elem) || !shard.decode(elem.value))
+            {
+                continue;
+            }
+            std::string_view key = elem.key;
+            if (key.size() < STATS_KEY.size() + 2 || key[key.size() - 2] != '\0')
+            {
+                continue;
+            }
+            std::string_view method = key.substr(STATS_KEY.size(), key.size() - STATS_KEY.size() - 2);
+            auto total = totals.find(method);
+            if (total == totals.end())
+            {
+                total = totals.emplace(std::string(method), CallCounters()).first;
+            }
+            total->second.add(shard);
+        }
+        JsonWriter json(64 + totals.size() * 160);
+        json.beginObject();
+        json.key("stats");
+        json.beginArray();
+        for (const auto &total : totals)
+        {
+            json.beginObject();
+            json.field("method", total.first);
+            total.second.writeJson(&json);
+            json.endObject();
+        }
+        json.endArray();
+        json.endObject();
+        ctx->ok(json.finish());
+    }
+
+private:
+    // S_<方法>\0<分块号>, 分块号为1字节, 由发起者和全部参数的哈希决定
+    std::string statsKey(xchain::Context *host) const
+    {
+        uint64_t h = fnv1a(host->initiator());
+        for (const auto &kv : host->args())
+        {
+            h = fnv1a(kv.second, fnv1a(kv.first, h));
+        }
+        std::string key;
+        key.reserve(STATS_KEY.size() + _method.size() + 2);
+        key.append(STATS_KEY).append(_method).append(1, '\0');
+        key += static_cast<char>(h % kStatsShards);
+        return key;
+    }
+
+    MeteredContext *_ctx;
+    std::string _method;
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// 分页游标: 把上一页最后一个账本键(去掉扫描前缀后的部分)编码为 base64url 字符串
+// 调用方只需原样回传, 不应解析其内容
+class Cursor
+{
+public:
+    static std::string encode(std::string_view position)
+    {
+        static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+        std::string out;
+        out.reserve((position.size() * 4 + 2) / 3);
+        size_t i = 0;
+        for (; i + 3 <= position.size(); i += 3)
+        {
+            uint32_t v = byte(position, i) << 16 | byte(position, i + 1) << 8 | byte(position, i + 2);
+            out += kAlphabet[v >> 18];
+            out += kAlphabet[(v >> 12) & 0x3f];
+            out += kAlphabet[(v >> 6) & 0x3f];
+            out += kAlphabet[v & 0x3f];
+        }
+        size_t rest = position.size() - i;
+        if (rest > 0)
+        {
+            uint32_t v = byte(position, i) << 16 | (rest == 2 ? byte(position, i + 1) << 8 : 0);
+            out += kAlphabet[v >> 18];
+            out += kAlphabet[(v >> 12) & 0x3f];
+            if (rest == 2)
+            {
+                out += kAlphabet[(v >> 6) & 0x3f];
+            }
+        }
+        return out;
+    }
+
+    static bool decode(std::string_view token, std::string *position)
+    {
+        if (token.size() % 4 == 1)
+        {
+            return false;
+        }
+        position->clear();
+        position->reserve(token.size() * 3 / 4);
+        uint32_t acc = 0;
+        int bits = 0;
+        for (char c : token)
+        {
+            int v = value(c);
+            if (v < 0)
+            {
+                return false;
+            }
+            acc = (acc << 6) | static_cast<uint32_t>(v);
+            bits += 6;
+            if (bits >= 8)
+            {
+                bits -= 8;
+                *position += static_cast<char>((acc >> bits) & 0xff);
+            }
+        }
+        return true;
+    }
+
+private:
+    static uint32_t byte(std::string_view s, size_t i)
+    {
+        return static_cast<uint8_t>(s[i]);
+    }
+
+    static int value(char c)
+    {
+        if (c >= 'A' && c <= 'Z')
+        {
+            return c - 'A';
+        }
+        if (c >= 'a' && c <= 'z')
+        {
+            return c - 'a' + 26;
+        }
+        if (c >= '0' && c <= '9')
+        {
+            return c - '0' + 52;
+        }
+        if (c == '-')
+        {
+            return 62;
+        }
+        if (c == '_')
+        {
+            return 63;
+        }
+        return -1;
+    }
+};
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "varint.h"
+
+// 基于预置字典的LZ77压缩, 面向几百字节的短记录
+// 匹配既可以引用本条记录前面的内容, 也可以越过开头引用字典末尾, 因此短记录也能压缩
+// 压缩流由若干块组成, 每块以 varint 头开始:
+//   头 & 1 == 0: 字面量, 头>>1 为长度, 后跟原文
+//   头 & 1 == 1: 匹配, 头>>1 为长度-kMinMatch, 后跟 varint(距离)
+//                距离从当前输出位置向前数, 大于已输出长度时落在字典中
+// 压缩时为字典建一次哈希表, 解压不需要任何表
+class DictCompressor
+{
+public:
+    static constexpr size_t kMinMatch = 4;
+
+    explicit DictCompressor(std::string_view dict) : _dict(dict)
+    {
+        _table.fill(-1);
+        for (size_t p = 0; p + kMinMatch <= _dict.size(); p++)
+        {
+            // 同一哈希保留最后出现的位置, 距离更短
+            _table[hash(_dict.data() + p, kDictHashBits)] = static_cast<int32_t>(p);
+        }
+    }
+
+    std::string_view dict() const
+    {
+        return _dict;
+    }
+
+    // 压缩 input, 结果追加到 out 末尾
+    void compress(std::string_view input, std::string *out) const
+    {
+        std::array<int32_t, size_t(1) << kInputHashBits> recent;
+        recent.fill(-1);
+        size_t literal = 0;
+        size_t i = 0;
+        while (i + kMinMatch <= input.size())
+        {
+            const char *p = input.data() + i;
+            size_t bestLen = 0;
+            size_t bestDist = 0;
+            int32_t &slot = recent[hash(p, kInputHashBits)];
+            if (slot >= 0)
+            {
+                size_t c = static_cast<size_t>(slot);
+                size_t len = matchLength(input.data() + c, p, input.size() - i);
+                if (len >= kMinMatch)
+                {
+                    bestLen = len;
+                    bestDist = i - c;
+                }
+            }
+            int32_t d = _table[hash(p, kDictHashBits)];
+            if (d >= 0)
+            {
+                size_t c = static_cast<size_t>(d);
+                size_t len = matchLength(_dict.data() + c, p, std::min(_dict.size() - c, input.size() - i));
+                if (len > bestLen)
+                {
+                    bestLen = len;
+                    bestDist = _dict.size() - c + i;
+                }
+            }
+            slot = static_cast<int32_t>(i);
+            if (bestLen < kMinMatch)
+            {
+                i++;
+                continue;
+            }
+            putLiteral(input.substr(literal, i - literal), out);
+            Varint::put(out, ((bestLen - kMinMatch) << 1) | 1);
+            Varint::put(out, bestDist);
+            i += bestLen;
+            literal = i;
+        }
+        putLiteral(input.substr(literal), out);
+    }
+
+    // 用字典 dict 解压出恰好 rawSize 字节到 out, 流损坏时返回false; 解压不需要哈希表
+    static bool decompress(std::string_view dict, std::string_view in, size_t rawSize, std::string *out)
+    {
+        out->resize(rawSize);
+        char *dst = out->data();
+        size_t written = 0;
+        size_t pos = 0;
+        while (pos < in.size())
+        {
+            uint64_t head;
+            if (!Varint::get(in, &pos, &head))
+            {
+                return false;
+            }
+            uint64_t len = head >> 1;
+            if (!(head & 1))
+            {
+                if (len > in.size() - pos || len > rawSize - written)
+                {
+                    return false;
+                }
+                std::memcpy(dst + written, in.data() + pos, len);
+                written += len;
+                pos += len;
+                continue;
+            }
+            uint64_t dist;
+            if (!Varint::get(in, &pos, &dist))
+            {
+                return false;
+            }
+            len += kMinMatch;
+            if (dist == 0 || dist > written + dict.size() || len > rawSize - written)
+            {
+                return false;
+            }
+            // 先复制落在字典中的部分, 再复制已输出的部分; 与正在输出的内容重叠时只能逐字节复制
+            if (dist > written)
+            {
+                size_t start = dict.size() - (dist - written);
+                size_t n = std::min<size_t>(len, dict.size() - start);
+                std::memcpy(dst + written, dict.data() + start, n);
+                written += n;
+                len -= n;
+            }
+            if (len == 0)
+            {
+                continue;
+            }
+            if (len <= dist)
+            {
+                std::memcpy(dst + written, dst + written - dist, len);
+                written += len;
+                continue;
+            }
+            for (uint64_t k = 0; k < len; k++, written++)
+            {
+                dst[written] = dst[written - dist];
+            }
+        }
+        return written == rawSize;
+    }
+
+private:
+    static constexpr int kDictHashBits = 12;
+    static constexpr int kInputHashBits = 8;
+
+    static uint32_t hash(const char *p, int bits)
+    {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return (v * 2654435761u) >> (32 - bits);
+    }
+
+    static size_t matchLength(const char *a, const char *b, size_t limit)
+    {
+        size_t n = 0;
+        while (n < limit && a[n] == b[n])
+        {
+            n++;
+        }
+        return n;
+    }
+
+    static void putLiteral(std::string_view s, std::string *out)
+    {
+        if (s.empty())
+        {
+            return;
+        }
+        Varint::put(out, s.size() << 1);
+        out->append(s);
+    }
+
+    std::string_view _dict;
+    std::array<int32_t, size_t(1) << kDictHashBits> _table;
+};
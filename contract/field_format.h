@@ -0,0 +1,274 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Decimal/Date 字段的规范文本格式与数值之间的转换
+// 只有能逐字还原的写法才被解析, 因此解析后再格式化总能得到原文
+class FieldFormat
+{
+public:
+    // 定点数最多18位有效数字, 保证尾数不溢出 int64
+    static constexpr size_t kMaxDigits = 18;
+
+    // 只接受能逐字还原的规范写法: -?(0|[1-9][0-9]*)(\.[0-9]+)?, 不含 "-0"
+    static bool parseDecimal(std::string_view s, int64_t *mantissa, uint64_t *scale)
+    {
+        size_t pos = 0;
+        bool negative = false;
+        if (pos < s.size() && s[pos] == '-')
+        {
+            negative = true;
+            pos++;
+        }
+        size_t intStart = pos;
+        while (pos < s.size() && s[pos] >= '0' && s[pos] <= '9')
+        {
+            pos++;
+        }
+        size_t intDigits = pos - intStart;
+        if (intDigits == 0 || (intDigits > 1 && s[intStart] == '0'))
+        {
+            return false;
+        }
+        size_t fracDigits = 0;
+        if (pos < s.size() && s[pos] == '.')
+        {
+            pos++;
+            size_t fracStart = pos;
+            while (pos < s.size() && s[pos] >= '0' && s[pos] <= '9')
+            {
+                pos++;
+            }
+            fracDigits = pos - fracStart;
+            if (fracDigits == 0)
+            {
+                return false;
+            }
+        }
+        if (pos != s.size() || intDigits + fracDigits > kMaxDigits)
+        {
+            return false;
+        }
+        int64_t v = 0;
+        for (char c : s)
+        {
+            if (c >= '0' && c <= '9')
+            {
+                v = v * 10 + (c - '0');
+            }
+        }
+        if (negative && v == 0)
+        {
+            return false;
+        }
+        *mantissa = negative ? -v : v;
+        *scale = fracDigits;
+        return true;
+    }
+
+    static void formatDecimal(std::string *out, int64_t mantissa, uint64_t scale)
+    {
+        char digits[24];
+        size_t len = 0;
+        uint64_t v = mantissa < 0 ? 0 - static_cast<uint64_t>(mantissa) : static_cast<uint64_t>(mantissa);
+        do
+        {
+            digits[len++] = static_cast<char>('0' + v % 10);
+            v /= 10;
+        } while (v > 0 && len < sizeof(digits));
+        while (len <= scale && len < sizeof(digits))
+        {
+            digits[len++] = '0';
+        }
+        out->clear();
+        if (mantissa < 0)
+        {
+            *out += '-';
+        }
+        while (len > 0)
+        {
+            if (len == scale)
+            {
+                *out += '.';
+            }
+            *out += digits[--len];
+        }
+    }
+
+    // 公历日期距1970-01-01的天数
+    static int64_t daysFromCivil(int64_t y, unsigned m, unsigned d)
+    {
+        y -= m <= 2;
+        int64_t era = (y >= 0 ? y : y - 399) / 400;
+        unsigned yoe = static_cast<unsigned>(y - era * 400);
+        unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<int64_t>(doe) - 719468;
+    }
+
+    // 只接受 YYYY-MM-DD 且日期真实存在
+    static bool parseDate(std::string_view s, int64_t *days)
+    {
+        if (s.size() != 10 || s[4] != '-' || s[7] != '-')
+        {
+            return false;
+        }
+        unsigned v[8];
+        static const size_t kDigitPos[8] = {0, 1, 2, 3, 5, 6, 8, 9};
+        for (size_t i = 0; i < 8; i++)
+        {
+            char c = s[kDigitPos[i]];
+            if (c < '0' || c > '9')
+            {
+                return false;
+            }
+            v[i] = static_cast<unsigned>(c - '0');
+        }
+        return civilDays(v[0] * 1000 + v[1] * 100 + v[2] * 10 + v[3], v[4] * 10 + v[5], v[6] * 10 + v[7], days);
+    }
+
+    // 从期限文本中取最后一个日期, 如 "2021-03-15至2041-03-14"、"2016.05.20-2036.05.20"、"2041年3月14日"
+    // 日期为4位年份加1~2位月、日, 分隔符为 - . / 或 年月日, 也接受连写的 YYYYMMDD; 没有日期(如 "长期")时返回false
+    static bool parseExpiry(std::string_view s, int64_t *days)
+    {
+        bool found = false;
+        size_t i = 0;
+        while (i < s.size())
+        {
+            if (!isDigit(s[i]))
+            {
+                i++;
+                continue;
+            }
+            size_t run = digitRun(s, i);
+            size_t end = i + run;
+            int64_t v;
+            if (run == 8 && civilDays(number(s, i, 4), number(s, i + 4, 2), number(s, i + 6, 2), &v))
+            {
+                *days = v;
+                found = true;
+            }
+            else if (run == 4 && matchDate(s, i, &v, &end))
+            {
+                *days = v;
+                found = true;
+            }
+            i = end;
+        }
+        return found;
+    }
+
+    static void formatDate(std::string *out, int64_t days)
+    {
+        days += 719468;
+        int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+        unsigned doe = static_cast<unsigned>(days - era * 146097);
+        unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        int64_t y = static_cast<int64_t>(yoe) + era * 400;
+        unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        unsigned mp = (5 * doy + 2) / 153;
+        unsigned d = doy - (153 * mp + 2) / 5 + 1;
+        unsigned m = mp < 10 ? mp + 3 : mp - 9;
+        y += m <= 2;
+        char buf[10] = {
+            static_cast<char>('0' + y / 1000 % 10), static_cast<char>('0' + y / 100 % 10),
+            static_cast<char>('0' + y / 10 % 10),   static_cast<char>('0' + y % 10),
+            '-',
+            static_cast<char>('0' + m / 10),        static_cast<char>('0' + m % 10),
+            '-',
+            static_cast<char>('0' + d / 10),        static_cast<char>('0' + d % 10),
+        };
+        out->assign(buf, sizeof(buf));
+    }
+
+private:
+    static bool isDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    static size_t digitRun(std::string_view s, size_t pos)
+    {
+        size_t n = 0;
+        while (pos + n < s.size() && isDigit(s[pos + n]))
+        {
+            n++;
+        }
+        return n;
+    }
+
+    static unsigned number(std::string_view s, size_t pos, size_t len)
+    {
+        unsigned v = 0;
+        for (size_t i = 0; i < len; i++)
+        {
+            v = v * 10 + static_cast<unsigned>(s[pos + i] - '0');
+        }
+        return v;
+    }
+
+    // 跳过一个 - . / 或 unit
+    static bool skipSeparator(std::string_view s, size_t *pos, std::string_view unit)
+    {
+        if (*pos < s.size() && (s[*pos] == '-' || s[*pos] == '.' || s[*pos] == '/'))
+        {
+            (*pos)++;
+            return true;
+        }
+        if (s.substr(*pos, unit.size()) == unit)
+        {
+            *pos += unit.size();
+            return true;
+        }
+        return false;
+    }
+
+    // 读取恰好1~2位的数字
+    static bool shortNumber(std::string_view s, size_t *pos, unsigned *v)
+    {
+        size_t len = digitRun(s, *pos);
+        if (len < 1 || len > 2)
+        {
+            return false;
+        }
+        *v = number(s, *pos, len);
+        *pos += len;
+        return true;
+    }
+
+    // s[pos] 起为 4位年份、分隔符、月、分隔符、日 时解析出日期, *end 置于日之后
+    static bool matchDate(std::string_view s, size_t pos, int64_t *days, size_t *end)
+    {
+        unsigned y = number(s, pos, 4);
+        unsigned m;
+        unsigned d;
+        pos += 4;
+        if (!skipSeparator(s, &pos, "年") || !shortNumber(s, &pos, &m) || !skipSeparator(s, &pos, "月") ||
+            !shortNumber(s, &pos, &d))
+        {
+            return false;
+        }
+        *end = pos;
+        return civilDays(y, m, d, days);
+    }
+
+    // 校验年月日真实存在并换算为天数
+    static bool civilDays(unsigned y, unsigned m, unsigned d, int64_t *days)
+    {
+        static const unsigned kMonthDays[12] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        if (y < 1000 || m < 1 || m > 12 || d < 1 || d > kMonthDays[m - 1])
+        {
+            return false;
+        }
+        bool leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+        if (m == 2 && d == 29 && !leap)
+        {
+            return false;
+        }
+        *days = daysFromCivil(y, m, d);
+        return true;
+    }
+};
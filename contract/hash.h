@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// 64位 FNV-1a 哈希, 用于把键均匀地分到若干分块; 各节点上结果相同, 可以决定账本键
+// h 为之前各段的哈希时可以连续地哈希多段数据
+inline uint64_t fnv1a(std::string_view key, uint64_t h = 14695981039346656037ull)
+{
+    for (unsigned char c : key)
+    {
+        h = (h ^ c) * 1099511628211ull;
+    }
+    return h;
+}
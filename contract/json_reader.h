@@ -0,0 +1,352 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// 只向前的json读取器, 用于解析批量接口传入的数组和对象参数
+// 不含转义的字符串直接返回指向原文的视图, 含转义时才解码到调用方提供的缓冲区
+//
+//     JsonReader in(text);
+//     if (in.beginArray())
+//         while (in.next())
+//             ... 读取一个元素 ...
+//     if (in.failed() || !in.finish()) 出错
+class JsonReader
+{
+public:
+    static constexpr int kMaxDepth = 32;
+
+    explicit JsonReader(std::string_view text) : _s(text) {}
+
+    bool beginObject()
+    {
+        return begin('{', '}');
+    }
+
+    bool beginArray()
+    {
+        return begin('[', ']');
+    }
+
+    // 前进到当前数组/对象的下一个元素
+    // 遇到结束符时消耗它并返回false; 语法错误也返回false, 由 failed() 区分
+    bool next()
+    {
+        if (_failed || _depth == 0)
+        {
+            return false;
+        }
+        skipSpace();
+        if (peek() == _close[_depth - 1])
+        {
+            _pos++;
+            _depth--;
+            return false;
+        }
+        if (!_first[_depth - 1])
+        {
+            if (peek() != ',')
+            {
+                return fail();
+            }
+            _pos++;
+        }
+        _first[_depth - 1] = false;
+        return true;
+    }
+
+    // 读取对象成员的键及其后的冒号
+    bool key(std::string_view *out, std::string *buf)
+    {
+        if (!readString(out, buf))
+        {
+            return false;
+        }
+        skipSpace();
+        if (peek() != ':')
+        {
+            return fail();
+        }
+        _pos++;
+        return true;
+    }
+
+    // 读取字符串值; 数字和true/false按原文返回, 便于把数值字段当作文本处理
+    bool scalar(std::string_view *out, std::string *buf)
+    {
+        skipSpace();
+        if (peek() == '"')
+        {
+            return readString(out, buf);
+        }
+        size_t start = _pos;
+        while (_pos < _s.size() && isScalarChar(_s[_pos]))
+        {
+            _pos++;
+        }
+        if (_pos == start)
+        {
+            return fail();
+        }
+        *out = _s.substr(start, _pos - start);
+        if (*out == "null")
+        {
+            *out = std::string_view();
+        }
+        return true;
+    }
+
+    // 跳过任意一个值, 包括嵌套的数组和对象
+    bool skip()
+    {
+        skipSpace();
+        char c = peek();
+        if (c == '{' || c == '[')
+        {
+            int depth = _depth;
+            begin(c, c == '{' ? '}' : ']');
+            while (!_failed && _depth > depth)
+            {
+                if (!next())
+                {
+                    continue;
+                }
+                if (_close[_depth - 1] == '}')
+                {
+                    std::string_view k;
+                    std::string buf;
+                    if (!key(&k, &buf))
+                    {
+                        return false;
+                    }
+                }
+                if (!skip())
+                {
+                    return false;
+                }
+            }
+            return !_failed;
+        }
+        std::string_view v;
+        std::string buf;
+        return scalar(&v, &buf);
+    }
+
+    // 整个输入已读完, 只剩空白
+    bool finish()
+    {
+        skipSpace();
+        return !_failed && _depth == 0 && _pos == _s.size();
+    }
+
+    bool failed() const
+    {
+        return _failed;
+    }
+
+private:
+    static bool isScalarChar(char c)
+    {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '-' || c == '+' || c == '.' ||
+               c == 'E';
+    }
+
+    char peek() const
+    {
+        return _pos < _s.size() ? _s[_pos] : '\0';
+    }
+
+    void skipSpace()
+    {
+        while (_pos < _s.size() && (_s[_pos] == ' ' || _s[_pos] == '\t' || _s[_pos] == '\n' || _s[_pos] == '\r'))
+        {
+            _pos++;
+        }
+    }
+
+    bool fail()
+    {
+        _failed = true;
+        return false;
+    }
+
+    bool begin(char open, char close)
+    {
+        skipSpace();
+        if (_failed || peek() != open || _depth == kMaxDepth)
+        {
+            return fail();
+        }
+        _pos++;
+        _close[_depth] = close;
+        _first[_depth] = true;
+        _depth++;
+        return true;
+    }
+
+    static int hexValue(char c)
+    {
+        if (c >= '0' && c <= '9')
+        {
+            return c - '0';
+        }
+        if (c >= 'a' && c <= 'f')
+        {
+            return c - 'a' + 10;
+        }
+        if (c >= 'A' && c <= 'F')
+        {
+            return c - 'A' + 10;
+        }
+        return -1;
+    }
+
+    bool readHex4(uint32_t *out)
+    {
+        if (_pos + 4 > _s.size())
+        {
+            return fail();
+        }
+        uint32_t v = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            int h = hexValue(_s[_pos++]);
+            if (h < 0)
+            {
+                return fail();
+            }
+            v = (v << 4) | static_cast<uint32_t>(h);
+        }
+        *out = v;
+        return true;
+    }
+
+    static void appendUtf8(std::string *buf, uint32_t cp)
+    {
+        if (cp < 0x80)
+        {
+            *buf += static_cast<char>(cp);
+        }
+        else if (cp < 0x800)
+        {
+            *buf += static_cast<char>(0xc0 | (cp >> 6));
+            *buf += static_cast<char>(0x80 | (cp & 0x3f));
+        }
+        else if (cp < 0x10000)
+        {
+            *buf += static_cast<char>(0xe0 | (cp >> 12));
+            *buf += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+            *buf += static_cast<char>(0x80 | (cp & 0x3f));
+        }
+        else
+        {
+            *buf += static_cast<char>(0xf0 | (cp >> 18));
+            *buf += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+            *buf += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+            *buf += static_cast<char>(0x80 | (cp & 0x3f));
+        }
+    }
+
+    bool readString(std::string_view *out, std::string *buf)
+    {
+        skipSpace();
+        if (_failed || peek() != '"')
+        {
+            return fail();
+        }
+        size_t start = ++_pos;
+        while (_pos < _s.size() && _s[_pos] != '"' && _s[_pos] != '\\')
+        {
+            _pos++;
+        }
+        if (_pos >= _s.size())
+        {
+            return fail();
+        }
+        if (_s[_pos] == '"')
+        {
+            *out = _s.substr(start, _pos - start);
+            _pos++;
+            return true;
+        }
+
+        // 含转义, 解码到缓冲区
+        buf->assign(_s.data() + start, _pos - start);
+        while (_pos < _s.size() && _s[_pos] != '"')
+        {
+            char c = _s[_pos++];
+            if (c != '\\')
+            {
+                *buf += c;
+                continue;
+            }
+            if (_pos >= _s.size())
+            {
+                return fail();
+            }
+            char e = _s[_pos++];
+            switch (e)
+            {
+            case '"':
+            case '\\':
+            case '/':
+                *buf += e;
+                break;
+            case 'b':
+                *buf += '\b';
+                break;
+            case 'f':
+                *buf += '\f';
+                break;
+            case 'n':
+                *buf += '\n';
+                break;
+            case 'r':
+                *buf += '\r';
+                break;
+            case 't':
+                *buf += '\t';
+                break;
+            case 'u':
+            {
+                uint32_t cp;
+                if (!readHex4(&cp))
+                {
+                    return false;
+                }
+                // UTF-16代理对
+                if (cp >= 0xd800 && cp < 0xdc00 && _pos + 1 < _s.size() && _s[_pos] == '\\' && _s[_pos + 1] == 'u')
+                {
+                    _pos += 2;
+                    uint32_t low;
+                    if (!readHex4(&low) || low < 0xdc00 || low >= 0xe000)
+                    {
+                        return fail();
+                    }
+                    cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+                }
+                appendUtf8(buf, cp);
+                break;
+            }
+            default:
+                return fail();
+            }
+        }
+        if (_pos >= _s.size())
+        {
+            return fail();
+        }
+        _pos++;
+        *out = *buf;
+        return true;
+    }
+
+    std::string_view _s;
+    size_t _pos = 0;
+    bool _failed = false;
+    int _depth = 0;
+    char _close[kMaxDepth];
+    bool _first[kMaxDepth];
+};
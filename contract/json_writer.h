@@ -0,0 +1,215 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// 流式json写入器, 所有内容写入同一个缓冲区
+// 调用方可先用 fieldSize 等估算总长度并在构造时一次性预留, 整个输出只分配一次
+// 估算按未转义的长度计, 不为此扫描字符串; 转义只在写入时扫描一遍, 多出的长度由 kEscapeSlack 吸收
+// 中文等非ASCII的UTF-8字节原样输出, 只转义引号、反斜杠和控制字符
+class JsonWriter
+{
+public:
+    // "{" 与 "}"
+    static constexpr size_t kObjectOverhead = 2;
+
+    // 预留时额外留出的字节数, 够十几个引号或反斜杠转义; 转义更多时缓冲区再扩容一次
+    static constexpr size_t kEscapeSlack = 16;
+
+    explicit JsonWriter(size_t capacity = 0)
+    {
+        _out.reserve(capacity > 0 ? capacity + kEscapeSlack : 0);
+    }
+
+    // 一个 "key":"value" 字段在不需转义时占用的长度, 含分隔逗号
+    static size_t fieldSize(std::string_view key, std::string_view value)
+    {
+        return key.size() + value.size() + 6;
+    }
+
+    void beginObject()
+    {
+        separate();
+        _out += '{';
+        _comma = false;
+    }
+
+    void endObject()
+    {
+        _out += '}';
+        _comma = true;
+    }
+
+    void beginArray()
+    {
+        separate();
+        _out += '[';
+        _comma = false;
+    }
+
+    void endArray()
+    {
+        _out += ']';
+        _comma = true;
+    }
+
+    void key(std::string_view k)
+    {
+        separate();
+        appendString(k);
+        _out += ':';
+        _comma = false;
+    }
+
+    void string(std::string_view s)
+    {
+        separate();
+        appendString(s);
+        _comma = true;
+    }
+
+    void number(uint64_t n)
+    {
+        char buf[20];
+        size_t len = 0;
+        do
+        {
+            buf[len++] = static_cast<char>('0' + n % 10);
+            n /= 10;
+        } while (n > 0);
+        separate();
+        while (len > 0)
+        {
+            _out += buf[--len];
+        }
+        _comma = true;
+    }
+
+    void boolean(bool b)
+    {
+        separate();
+        _out.append(b ? "true" : "false");
+        _comma = true;
+    }
+
+    // 写入已经是合法json的值(嵌套对象、已存储的记录等), 原样输出
+    void raw(std::string_view json)
+    {
+        separate();
+        _out.append(json);
+        _comma = true;
+    }
+
+    void field(std::string_view k, std::string_view value)
+    {
+        key(k);
+        string(value);
+    }
+
+    void rawField(std::string_view k, std::string_view json)
+    {
+        key(k);
+        raw(json);
+    }
+
+    std::string finish()
+    {
+        return std::move(_out);
+    }
+
+private:
+    static bool needsEscape(unsigned char c)
+    {
+        return c < 0x20 || c == '"' || c == '\\';
+    }
+
+    // 从 from 开始查找第一个需要转义的字节, 没有则返回 s.size()
+    // 每次检查8个字节, 绝大多数字段(包括全部中文)整段跳过
+    static size_t findEscape(std::string_view s, size_t from)
+    {
+        const uint64_t kOnes = 0x0101010101010101ULL;
+        const uint64_t kHigh = 0x8080808080808080ULL;
+        size_t i = from;
+        for (; i + 8 <= s.size(); i += 8)
+        {
+            uint64_t w;
+            std::memcpy(&w, s.data() + i, 8);
+            uint64_t quote = w ^ (kOnes * '"');
+            uint64_t slash = w ^ (kOnes * '\\');
+            uint64_t hit = ((w - kOnes * 0x20) & ~w) | ((quote - kOnes) & ~quote) | ((slash - kOnes) & ~slash);
+            if (hit & kHigh)
+            {
+                break;
+            }
+        }
+        for (; i < s.size(); i++)
+        {
+            if (needsEscape(s[i]))
+            {
+                return i;
+            }
+        }
+        return s.size();
+    }
+
+    void separate()
+    {
+        if (_comma)
+        {
+            _out += ',';
+        }
+    }
+
+    void appendString(std::string_view s)
+    {
+        static const char kHex[] = "0123456789abcdef";
+        _out += '"';
+        size_t run = 0;
+        for (size_t i = findEscape(s, 0); i < s.size(); i = findEscape(s, i + 1))
+        {
+            unsigned char c = s[i];
+            // 先整段拷贝无需转义的部分
+            _out.append(s.data() + run, i - run);
+            run = i + 1;
+            _out += '\\';
+            switch (c)
+            {
+            case '"':
+                _out += '"';
+                break;
+            case '\\':
+                _out += '\\';
+                break;
+            case '\b':
+                _out += 'b';
+                break;
+            case '\f':
+                _out += 'f';
+                break;
+            case '\n':
+                _out += 'n';
+                break;
+            case '\r':
+                _out += 'r';
+                break;
+            case '\t':
+                _out += 't';
+                break;
+            default:
+                _out.append("u00");
+                _out += kHex[c >> 4];
+                _out += kHex[c & 0xf];
+                break;
+            }
+        }
+        _out.append(s.data() + run, s.size() - run);
+        _out += '"';
+    }
+
+    std::string _out;
+    bool _comma = false;
+};
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "xchain/crypto.h"
+#include "xchain/xchain.h"
+
+#include "varint.h"
+
+// 账本上的增量 Merkle 树, 叶子按首次写入的顺序编号, 之后同一叶子可以原地更新
+// 键(均带构造时给定的前缀):
+//   L_<key>           - 叶子编号, Fixed64
+//   M_<层><编号>       - 节点哈希, 层为1字节, 编号为 Fixed64; 叶子在第0层
+//   Root              - Fixed64(叶子数) 加根哈希
+// 叶子数为 n 时树高 h 为满足 2^h >= n 的最小值, 根为第h层第0个节点
+// 内部节点 = sha256(0x01 || 左 || 右), 不存在的节点取 32 个零字节
+// 更新一个叶子读写 O(h) 个节点; 叶子数越过2的幂时旧根直接成为新根的左子树, 不需要重建
+class MerkleTree
+{
+public:
+    static constexpr size_t kHashSize = 32;
+
+    // 一个叶子的包含证明, siblings 从第0层向上排列
+    struct Proof
+    {
+        uint64_t index = 0;
+        uint64_t leaves = 0;
+        std::string leaf;
+        std::string root;
+        std::vector<std::string> siblings;
+    };
+
+    explicit MerkleTree(const std::string &ns)
+        : LEAF_KEY(ns + "L_"), NODE_KEY(ns + "M_"), ROOT_KEY(ns + "Root")
+    {
+    }
+
+    // 叶子哈希: sha256(0x00 || data)
+    static std::string leafHash(std::string_view data)
+    {
+        std::string input;
+        input.reserve(1 + data.size());
+        input.append(1, '\0').append(data);
+        return xchain::crypto::sha256(input);
+    }
+
+    // 把 key 对应的叶子设为 leaf, 新的 key 追加到最右侧, 并重算到根的路径
+    bool update(xchain::Context *ctx, std::string_view key, const std::string &leaf)
+    {
+        uint64_t leaves;
+        std::string root;
+        if (!loadRoot(ctx, &leaves, &root))
+        {
+            return false;
+        }
+        uint64_t index;
+        std::string leafKey = LEAF_KEY + std::string(key);
+        std::string stored;
+        if (ctx->get_object(leafKey, &stored))
+        {
+            if (!Fixed64::get(stored, &index) || index >= leaves)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            index = leaves++;
+            stored.clear();
+            Fixed64::put(&stored, index);
+            if (!ctx->put_object(leafKey, stored))
+            {
+                return false;
+            }
+        }
+
+        std::string hash = leaf;
+        if (!ctx->put_object(nodeKey(0, index), hash))
+        {
+            return false;
+        }
+        int height = heightOf(leaves);
+        uint64_t pos = index;
+        std::string sibling;
+        for (int level = 0; level < height; level++, pos >>= 1)
+        {
+            loadNode(ctx, level, pos ^ 1, &sibling);
+            hash = (pos & 1) ? parentHash(sibling, hash) : parentHash(hash, sibling);
+            if (!ctx->put_object(nodeKey(level + 1, pos >> 1), hash))
+            {
+                return false;
+            }
+        }
+        stored.clear();
+        Fixed64::put(&stored, leaves);
+        stored.append(hash);
+        return ctx->put_object(ROOT_KEY, stored);
+    }
+
+    // 读出 key 的包含证明, key 不在树中返回false
+    bool prove(xchain::Context *ctx, std::string_view key, Proof *proof)
+    {
+        std::string stored;
+        if (!ctx->get_object(LEAF_KEY + std::string(key), &stored) || !Fixed64::get(stored, &proof->index) ||
+            !loadRoot(ctx, &proof->leaves, &proof->root) || proof->index >= proof->leaves)
+        {
+            return false;
+        }
+        loadNode(ctx, 0, proof->index, &proof->leaf);
+        int height = heightOf(proof->leaves);
+        proof->siblings.resize(height);
+        uint64_t pos = proof->index;
+        for (int level = 0; level < height; level++, pos >>= 1)
+        {
+            loadNode(ctx, level, pos ^ 1, &proof->siblings[level]);
+        }
+        return true;
+    }
+
+private:
+    const std::string LEAF_KEY;
+    const std::string NODE_KEY;
+    const std::string ROOT_KEY;
+
+    static int heightOf(uint64_t leaves)
+    {
+        int height = 0;
+        while (height < 64 && (uint64_t(1) << height) < leaves)
+        {
+            height++;
+        }
+        return height;
+    }
+
+    static std::string parentHash(const std::string &left, const std::string &right)
+    {
+        std::string input;
+        input.reserve(1 + 2 * kHashSize);
+        input.append(1, '\x01').append(left).append(right);
+        return xchain::crypto::sha256(input);
+    }
+
+    std::string nodeKey(int level, uint64_t index) const
+    {
+        std::string key;
+        key.reserve(NODE_KEY.size() + 1 + Fixed64::kSize);
+        key.append(NODE_KEY).append(1, static_cast<char>(level));
+        Fixed64::put(&key, index);
+        return key;
+    }
+
+    // 不存在的节点取零哈希
+    void loadNode(xchain::Context *ctx, int level, uint64_t index, std::string *hash) const
+    {
+        if (!ctx->get_object(nodeKey(level, index), hash) || hash->size() != kHashSize)
+        {
+            hash->assign(kHashSize, '\0');
+        }
+    }
+
+    // 空树的叶子数为0, 根为零哈希
+    bool loadRoot(xchain::Context *ctx, uint64_t *leaves, std::string *root) const
+    {
+        std::string stored;
+        if (!ctx->get_object(ROOT_KEY, &stored))
+        {
+            *leaves = 0;
+            root->assign(kHashSize, '\0');
+            return true;
+        }
+        if (stored.size() != Fixed64::kSize + kHashSize)
+        {
+            return false;
+        }
+        Fixed64::get(std::string_view(stored).substr(0, Fixed64::kSize), leaves);
+        root->assign(stored, Fixed64::kSize, kHashSize);
+        return true;
+    }
+};
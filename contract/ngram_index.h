@@ -0,0 +1,253 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "xchain/xchain.h"
+
+// 账本上的二元组(bigram)倒排索引, 用于中文文本的关键词检索
+// 键: T_<二元组>\0<主键>, 值为主键; 同一二元组的倒排表按主键排序连续排列
+// 文本按标点和空白切成若干段, 每段取相邻两个字组成二元组, ASCII字母转为小写
+// 关键词的全部二元组都出现在记录中只是必要条件, 调用方应再核对原文
+class NgramIndex
+{
+public:
+    explicit NgramIndex(const std::string &ns) : TERM_KEY(ns + "T_")
+    {
+    }
+
+    // 文本中全部不重复的二元组, 已排序
+    static std::vector<std::string> terms(const std::vector<std::string_view> &texts)
+    {
+        std::vector<std::string> out;
+        for (std::string_view text : texts)
+        {
+            std::string prev;
+            size_t pos = 0;
+            while (pos < text.size())
+            {
+                std::string c = nextChar(text, &pos);
+                if (c.empty())
+                {
+                    prev.clear();
+                    continue;
+                }
+                if (!prev.empty())
+                {
+                    out.push_back(prev + c);
+                }
+                prev = std::move(c);
+            }
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        return out;
+    }
+
+    // 与 terms 相同的规范化: ASCII字母转为小写, 标点和空白换成 '\0', 用于核对原文
+    static std::string normalize(std::string_view text)
+    {
+        std::string out;
+        out.reserve(text.size());
+        size_t pos = 0;
+        while (pos < text.size())
+        {
+            std::string c = nextChar(text, &pos);
+            out.append(c.empty() ? std::string(1, '\0') : c);
+        }
+        return out;
+    }
+
+    // 把 key 的索引项从 oldTerms 改为 newTerms, 两者都须已排序; 只写入有变化的项
+    bool update(xchain::Context *ctx, std::string_view key, const std::vector<std::string> &oldTerms,
+                const std::vector<std::string> &newTerms)
+    {
+        std::vector<std::string> removed;
+        std::set_difference(oldTerms.begin(), oldTerms.end(), newTerms.begin(), newTerms.end(),
+                            std::back_inserter(removed));
+        for (const std::string &term : removed)
+        {
+            ctx->delete_object(postingPrefix(term).append(key));
+        }
+        std::vector<std::string> added;
+        std::set_difference(newTerms.begin(), newTerms.end(), oldTerms.begin(), oldTerms.end(),
+                            std::back_inserter(added));
+        for (const std::string &term : added)
+        {
+            if (!ctx->put_object(postingPrefix(term).append(key), std::string(key)))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 多个倒排表的交集, 按主键升序逐个给出
+    // 以 leapfrog 方式轮流把每个表推进到当前候选主键, 表越稀疏跳得越远, 读取量取决于最稀疏的表
+    class Intersection
+    {
+    public:
+        // after 非空时只给出大于 after 的主键
+        Intersection(xchain::Context *ctx, const NgramIndex &index, const std::vector<std::string> &terms,
+                     const std::string &after)
+            : _ctx(ctx), _candidate(after.empty() ? std::string() : after + '\0')
+        {
+            for (const std::string &term : terms)
+            {
+                Posting p;
+                p.prefix = index.postingPrefix(term);
+                p.end = p.prefix;
+                p.end.back()++;
+                _postings.push_back(std::move(p));
+            }
+        }
+
+        // 取下一个同时出现在全部倒排表中的主键, 没有时返回false
+        bool next(std::string *key)
+        {
+            if (_postings.empty())
+            {
+                return false;
+            }
+            size_t agreed = 0;
+            for (size_t i = 0; agreed < _postings.size(); i = (i + 1) % _postings.size())
+            {
+                std::string found;
+                if (!seek(&_postings[i], _candidate, &found))
+                {
+                    _postings.clear();
+                    return false;
+                }
+                if (found == _candidate)
+                {
+                    agreed++;
+                    continue;
+                }
+                _candidate = std::move(found);
+                agreed = 1;
+            }
+            *key = _candidate;
+            _candidate.push_back('\0');
+            return true;
+        }
+
+    private:
+        // 顺序前进这么多步仍未到达目标时改为从目标处重新打开遍历器
+        static constexpr int kScanSteps = 4;
+
+        struct Posting
+        {
+            std::string prefix;
+            std::string end;
+            std::unique_ptr<xchain::Iterator> it;
+            std::string current;
+            bool exhausted = false;
+        };
+
+        // 把倒排表推进到第一个不小于 target 的主键
+        bool seek(Posting *p, const std::string &target, std::string *found)
+        {
+            if (p->exhausted)
+            {
+                return false;
+            }
+            if (p->it && p->current >= target)
+            {
+                *found = p->current;
+                return true;
+            }
+            for (int step = 0; p->it && step < kScanSteps; step++)
+            {
+                if (!advance(p))
+                {
+                    return false;
+                }
+                if (p->current >= target)
+                {
+                    *found = p->current;
+                    return true;
+                }
+            }
+            p->it = _ctx->new_iterator(p->prefix + target, p->end);
+            if (!advance(p))
+            {
+                return false;
+            }
+            *found = p->current;
+            return true;
+        }
+
+        bool advance(Posting *p)
+        {
+            xchain::ElemType elem;
+            if (!p->it->next() || !p->it->get(&elem))
+            {
+                p->exhausted = true;
+                return false;
+            }
+            p->current = elem.key.substr(p->prefix.size());
+            return true;
+        }
+
+        xchain::Context *_ctx;
+        std::vector<Posting> _postings;
+        std::string _candidate;
+    };
+
+private:
+    std::string postingPrefix(std::string_view term) const
+    {
+        std::string key;
+        key.reserve(TERM_KEY.size() + term.size() + 1 + 24);
+        key.append(TERM_KEY).append(term).append(1, '\0');
+        return key;
+    }
+
+    // 取出一个字符, ASCII字母转为小写; 标点、空白和控制字符返回空
+    static std::string nextChar(std::string_view text, size_t *pos)
+    {
+        uint8_t lead = static_cast<uint8_t>(text[*pos]);
+        size_t len = lead < 0x80 ? 1 : lead < 0xe0 ? 2 : lead < 0xf0 ? 3 : 4;
+        len = std::min(len, text.size() - *pos);
+        std::string_view c = text.substr(*pos, len);
+        *pos += len;
+        if (len == 1)
+        {
+            char a = c[0];
+            if (a >= 'A' && a <= 'Z')
+            {
+                return std::string(1, static_cast<char>(a - 'A' + 'a'));
+            }
+            bool alnum = (a >= 'a' && a <= 'z') || (a >= '0' && a <= '9');
+            return alnum ? std::string(c) : std::string();
+        }
+        return isPunctuation(c) ? std::string() : std::string(c);
+    }
+
+    // 常见的全角标点: U+2000-U+206F 通用标点, U+3000-U+303F 中文标点, U+FF00-U+FFEF 中的全角符号
+    static bool isPunctuation(std::string_view c)
+    {
+        if (c.size() != 3)
+        {
+            return false;
+        }
+        uint32_t cp = (static_cast<uint32_t>(c[0] & 0x0f) << 12) | (static_cast<uint32_t>(c[1] & 0x3f) << 6) |
+                      static_cast<uint32_t>(c[2] & 0x3f);
+        if ((cp >= 0x2000 && cp <= 0x206f) || (cp >= 0x3000 && cp <= 0x303f))
+        {
+            return true;
+        }
+        // 全角数字和字母不算标点
+        bool fullwidthAlnum = (cp >= 0xff10 && cp <= 0xff19) || (cp >= 0xff21 && cp <= 0xff3a) ||
+                              (cp >= 0xff41 && cp <= 0xff5a);
+        return cp >= 0xff00 && cp <= 0xffef && !fullwidthAlnum;
+    }
+
+    const std::string TERM_KEY;
+};
@@ -0,0 +1,496 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "dict_compressor.h"
+#include "field_format.h"
+#include "json_reader.h"
+#include "record_dict.h"
+#include "varint.h"
+
+// 字段的存储类型
+// Decimal/Date 字段在取值符合规范格式时按数值存储, 否则退化为文本, 读出时总能还原原文
+enum class FieldType
+{
+    Text,    // 任意文本
+    Decimal, // 十进制数, 如 45820.36, 存为定点数
+    Date,    // YYYY-MM-DD 日期, 存为距1970-01-01的天数
+};
+
+// 字段的附加能力, 可按位组合
+enum FieldFlag : unsigned
+{
+    FIELD_INDEXED = 1u << 0,         // 维护二级索引, 可按字段值查询
+    FIELD_INTERNED = 1u << 1,        // 较长的取值整体存入字典, 记录中只存引用
+    FIELD_INTERNED_PREFIX = 1u << 2, // 地址的行政区划前缀存入字典, 其余部分仍存在记录中
+    FIELD_GROUPED = 1u << 3,         // 按取值分组统计记录数, 可查询每个取值的汇总
+    FIELD_SUMMED = 1u << 4,          // Decimal 字段, 在每个分组中累计总和
+    FIELD_EXPIRY = 1u << 5,          // 期限文本, 写入时解析出到期日并按日期索引, 每个 Schema 至多一个
+    FIELD_REGION = 1u << 6,          // 地址, 写入时解析出行政区划层级并按层级索引, 每个 Schema 至多一个
+    FIELD_SEARCHED = 1u << 7,        // 中文文本, 维护二元组倒排索引, 可按关键词检索
+};
+
+// 带有上述任一字典标记的字段
+constexpr unsigned FIELD_INTERN_FLAGS = FIELD_INTERNED | FIELD_INTERNED_PREFIX;
+
+// 文本是否以单字的 市/县/区 开头
+inline bool regionSuffixFollows(std::string_view rest)
+{
+    static const std::string_view kSuffixes[] = {"市", "县", "区"};
+    for (std::string_view s : kSuffixes)
+    {
+        if (rest.substr(0, s.size()) == s)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// FIELD_INTERNED_PREFIX 字段中行政区划前缀的字节数: 前16个字符内第一个 区/县/旗 为止,
+// 没有时到最后一个 省/市/州/盟 为止, 都没有时返回0
+inline size_t regionPrefixSize(std::string_view address)
+{
+    static const std::string_view kCounty[] = {"区", "县", "旗"};
+    static const std::string_view kCity[] = {"省", "市", "州", "盟"};
+    const size_t kMaxChars = 16;
+    size_t city = 0;
+    size_t pos = 0;
+    for (size_t chars = 0; chars < kMaxChars && pos < address.size(); chars++)
+    {
+        uint8_t lead = static_cast<uint8_t>(address[pos]);
+        size_t len = lead < 0x80 ? 1 : lead < 0xe0 ? 2 : lead < 0xf0 ? 3 : 4;
+        std::string_view c = address.substr(pos, len);
+        pos += c.size();
+        for (std::string_view m : kCounty)
+        {
+            if (c == m)
+            {
+                return pos;
+            }
+        }
+        for (std::string_view m : kCity)
+        {
+            if (c == m)
+            {
+                city = pos;
+            }
+        }
+    }
+    return city;
+}
+
+// 地址开头的行政区划层级, 由大到小, 如 "北京市海淀区西北旺镇永丰路" 为 北京市、海淀区、西北旺镇
+constexpr size_t kRegionLevels = 4;
+using RegionPath = std::array<std::string_view, kRegionLevels>;
+
+// 按后缀逐级识别, 返回识别出的层数: 省级 省/自治区/特别行政区, 地级 市/自治州/地区/盟,
+// 县级 区/县/旗 及地级之后的市, 乡级 街道/镇/乡; 层级须由大到小, 遇到ASCII字符、超长或层级不符时停止
+// 只凭文本判断, 不查区划表: 省略了上级的地址(如 "海淀区...")从它写出的第一级开始
+inline size_t regionLevels(std::string_view address, RegionPath *levels)
+{
+    struct Suffix
+    {
+        std::string_view text;
+        int rank;
+    };
+    // 较长的后缀在前, "自治区" 先于 "区" 匹配
+    static const Suffix kSuffixes[] = {
+        {"特别行政区", 0}, {"自治区", 0}, {"省", 0}, {"自治州", 1}, {"地区", 1}, {"市", 1}, {"盟", 1},
+        {"区", 2},         {"县", 2},     {"旗", 2}, {"街道", 3},   {"镇", 3},   {"乡", 3},
+    };
+    const size_t kMaxChars = 12;
+    size_t count = 0;
+    size_t pos = 0;
+    int last = -1;
+    while (count < kRegionLevels && pos < address.size())
+    {
+        size_t end = pos;
+        int rank = -1;
+        for (size_t chars = 0; chars < kMaxChars && end < address.size() && rank < 0; chars++)
+        {
+            uint8_t lead = static_cast<uint8_t>(address[end]);
+            if (lead < 0x80)
+            {
+                break;
+            }
+            end += lead < 0xe0 ? 2 : lead < 0xf0 ? 3 : 4;
+            std::string_view name = address.substr(pos, end - pos);
+            for (const Suffix &s : kSuffixes)
+            {
+                // 后缀前至少有一个字; 紧跟着 市/县/区 时后缀只是地名的一部分, 如 "宁乡市"
+                if (name.size() > s.text.size() && name.substr(name.size() - s.text.size()) == s.text &&
+                    !regionSuffixFollows(address.substr(end)))
+                {
+                    rank = s.rank;
+                    break;
+                }
+            }
+        }
+        // 地级之后的市为县级市
+        if (rank == 1 && last >= 1)
+        {
+            rank = 2;
+        }
+        if (rank <= last)
+        {
+            break;
+        }
+        (*levels)[count++] = address.substr(pos, end - pos);
+        last = rank;
+        pos = end;
+    }
+    return count;
+}
+
+// Schema 可声明 static constexpr bool kCompressed = true, 用预置字典压缩记录的字段部分
+template <class Schema, class = void>
+struct CompressedSchema : std::false_type
+{
+};
+
+template <class Schema>
+struct CompressedSchema<Schema, std::void_t<decltype(Schema::kCompressed)>>
+    : std::bool_constant<Schema::kCompressed>
+{
+};
+
+// 记录字段的编译期描述, name 既是调用参数名, 也是查询返回json中的键名
+struct FieldSpec
+{
+    std::string_view name;
+    FieldType type = FieldType::Text;
+    unsigned flags = 0;
+};
+
+// 账本中记录值的二进制编码:
+//   [0] kFormat  [1] Schema::kSchemaId  varint(版本号)  之后按 kFields 顺序排列各字段
+//   普通 Text 字段:     varint(长度) + 原文
+//   其余字段:           varint 头, 低2位为标记, 见 tagged
+//       0: 文本, 头>>2 为长度, 后跟原文
+//       1: 定点数(Decimal), 头>>2 为小数位数, 后跟 zigzag varint 尾数
+//       2: 日期(Date), 后跟 zigzag varint 天数
+//       3: 字典引用(带字典标记的 Text 字段), 后跟 kRefSize 字节引用 + varint(长度) + 引用之后的原文
+// 主键 userid 已包含在账本键中, 不再重复存储
+// 压缩记录: [0] kFormat|kCompressedFlag  [1] kSchemaId  varint(版本号)  [字典编号]  varint(字段部分原长)
+//   之后是 DictCompressor 压缩后的字段部分; 只在压缩后更短时采用
+// 改造前写入的json记录以 '{' 开头, 读取时原样返回, 能解析时同时解出各字段, 同样视为版本1
+template <class Schema>
+class RecordCodec
+{
+public:
+    static constexpr size_t kFieldCount = std::size(Schema::kFields);
+    static constexpr uint8_t kFormat = 0x01;
+    static constexpr uint8_t kCompressedFlag = 0x80;
+    static constexpr bool kCompressed = CompressedSchema<Schema>::value;
+    // 字典引用的长度
+    static constexpr size_t kRefSize = 8;
+
+    using Values = std::array<std::string_view, kFieldCount>;
+
+    // 字典引用: 字段值的前 prefixSize 字节由字典中的 ref 代替, ref 为空表示不引用
+    struct Ref
+    {
+        std::string_view ref;
+        size_t prefixSize = 0;
+    };
+    using Refs = std::array<Ref, kFieldCount>;
+
+    // 解码结果: 文本字段指向存储值, 数值和日期字段格式化到 buf 中
+    // values 引用自身和存储值的内存, 解码后不可拷贝或移动
+    struct Decoded
+    {
+        Values values;
+        std::array<std::string, kFieldCount> buf;
+        // 旧版json记录原文, 非空时查询原样返回
+        std::string_view legacyJson;
+        // values 是否有效; 旧版记录含未转义的引号等无法解析时为false
+        bool hasValues = false;
+        // 记录版本号, 首次写入为1, 每次修改加1
+        uint64_t version = 0;
+        // 尚未解析的字典引用; 非空时 values[i] 只是引用之后的部分, 需由调用方查字典补全
+        std::array<std::string_view, kFieldCount> refs;
+        // 压缩记录解压后的字段部分
+        std::string raw;
+
+        Decoded() = default;
+        Decoded(const Decoded &) = delete;
+        Decoded &operator=(const Decoded &) = delete;
+    };
+
+    static std::string encode(const Values &values, uint64_t version)
+    {
+        return encode(version, encodeFields(values));
+    }
+
+    // 记录头 + 已编码的字段部分
+    static std::string encode(uint64_t version, std::string_view fields)
+    {
+        if constexpr (kCompressed)
+        {
+            std::string packed;
+            packed.reserve(fields.size());
+            compressor().compress(fields, &packed);
+            if (1 + Varint::size(fields.size()) + packed.size() < fields.size())
+            {
+                std::string out;
+                out.reserve(3 + Varint::size(version) + Varint::size(fields.size()) + packed.size());
+                out += static_cast<char>(kFormat | kCompressedFlag);
+                out += static_cast<char>(Schema::kSchemaId);
+                Varint::put(&out, version);
+                out += static_cast<char>(RECORD_DICT_ID);
+                Varint::put(&out, fields.size());
+                out.append(packed);
+                return out;
+            }
+        }
+        std::string out;
+        out.reserve(2 + Varint::size(version) + fields.size());
+        out += static_cast<char>(kFormat);
+        out += static_cast<char>(Schema::kSchemaId);
+        Varint::put(&out, version);
+        out.append(fields);
+        return out;
+    }
+
+    // 只编码字段部分, 不含记录头, 不引用字典; 相同内容的记录总是得到相同的字节
+    static std::string encodeFields(const Values &values)
+    {
+        return encodeFields(values, Refs());
+    }
+
+    // 同上, 带字典标记的字段按 refs 引用字典
+    static std::string encodeFields(const Values &values, const Refs &refs)
+    {
+        Encoded enc[kFieldCount];
+        size_t size = 0;
+        for (size_t i = 0; i < kFieldCount; i++)
+        {
+            enc[i] = classify(i, values[i], refs[i]);
+            size += enc[i].size;
+        }
+        std::string out;
+        out.reserve(size);
+        for (size_t i = 0; i < kFieldCount; i++)
+        {
+            const Encoded &e = enc[i];
+            if (!tagged(i))
+            {
+                Varint::put(&out, values[i].size());
+                out.append(values[i]);
+            }
+            else if (e.tag == kTagText)
+            {
+                Varint::put(&out, (values[i].size() << 2) | kTagText);
+                out.append(values[i]);
+            }
+            else if (e.tag == kTagRef)
+            {
+                std::string_view rest = values[i].substr(refs[i].prefixSize);
+                Varint::put(&out, kTagRef);
+                out.append(refs[i].ref);
+                Varint::put(&out, rest.size());
+                out.append(rest);
+            }
+            else if (e.tag == kTagDecimal)
+            {
+                Varint::put(&out, (e.scale << 2) | kTagDecimal);
+                Varint::put(&out, Varint::zigzag(e.number));
+            }
+            else
+            {
+                Varint::put(&out, kTagDate);
+                Varint::put(&out, Varint::zigzag(e.number));
+            }
+        }
+        return out;
+    }
+
+    static bool decode(std::string_view stored, Decoded *out)
+    {
+        if (!stored.empty() && stored[0] == '{')
+        {
+            out->legacyJson = stored;
+            out->hasValues = decodeLegacy(stored, out);
+            out->version = 1;
+            return true;
+        }
+        if (stored.size() < 2 || static_cast<uint8_t>(stored[1]) != Schema::kSchemaId)
+        {
+            return false;
+        }
+        size_t pos = 2;
+        uint8_t format = static_cast<uint8_t>(stored[0]);
+        bool compressed = format & kCompressedFlag;
+        if ((format & ~kCompressedFlag) != kFormat || !Varint::get(stored, &pos, &out->version))
+        {
+            return false;
+        }
+        if (compressed)
+        {
+            // 解压后按未压缩的字段部分继续解码
+            uint64_t rawSize;
+            if (pos >= stored.size() || static_cast<uint8_t>(stored[pos++]) != RECORD_DICT_ID ||
+                !Varint::get(stored, &pos, &rawSize) || rawSize > kMaxRawSize ||
+                !DictCompressor::decompress(RECORD_DICT, stored.substr(pos), rawSize, &out->raw))
+            {
+                return false;
+            }
+            stored = out->raw;
+            pos = 0;
+        }
+        for (size_t i = 0; i < kFieldCount; i++)
+        {
+            uint64_t head;
+            if (!Varint::get(stored, &pos, &head))
+            {
+                return false;
+            }
+            bool isTagged = tagged(i);
+            if (isTagged && (head & 3) == kTagRef && Schema::kFields[i].type == FieldType::Text)
+            {
+                if (kRefSize > stored.size() - pos)
+                {
+                    return false;
+                }
+                out->refs[i] = stored.substr(pos, kRefSize);
+                pos += kRefSize;
+                if (!Varint::get(stored, &pos, &head))
+                {
+                    return false;
+                }
+                isTagged = false;
+            }
+            if (!isTagged || (head & 3) == kTagText)
+            {
+                uint64_t len = isTagged ? head >> 2 : head;
+                if (len > stored.size() - pos)
+                {
+                    return false;
+                }
+                out->values[i] = stored.substr(pos, len);
+                pos += len;
+                continue;
+            }
+            uint64_t number;
+            if (!Varint::get(stored, &pos, &number))
+            {
+                return false;
+            }
+            std::string &buf = out->buf[i];
+            if ((head & 3) == kTagDecimal)
+            {
+                FieldFormat::formatDecimal(&buf, Varint::unzigzag(number), head >> 2);
+            }
+            else if ((head & 3) == kTagDate)
+            {
+                FieldFormat::formatDate(&buf, Varint::unzigzag(number));
+            }
+            else
+            {
+                return false;
+            }
+            out->values[i] = buf;
+        }
+        out->hasValues = pos == stored.size();
+        return out->hasValues;
+    }
+
+private:
+    static constexpr uint64_t kTagText = 0;
+    static constexpr uint64_t kTagDecimal = 1;
+    static constexpr uint64_t kTagDate = 2;
+    static constexpr uint64_t kTagRef = 3;
+    // 压缩记录解压后的长度上限, 防止损坏的数据申请过大的内存
+    static constexpr uint64_t kMaxRawSize = 1 << 20;
+
+    struct Encoded
+    {
+        uint64_t tag = kTagText;
+        uint64_t scale = 0;
+        int64_t number = 0;
+        size_t size = 0;
+    };
+
+    static bool decodeLegacy(std::string_view stored, Decoded *out)
+    {
+        JsonReader in(stored);
+        if (!in.beginObject())
+        {
+            return false;
+        }
+        std::string_view key;
+        std::string keyBuf;
+        std::string skipped;
+        while (in.next())
+        {
+            if (!in.key(&key, &keyBuf))
+            {
+                return false;
+            }
+            size_t i = 0;
+            while (i < kFieldCount && Schema::kFields[i].name != key)
+            {
+                i++;
+            }
+            std::string_view value;
+            if (!in.scalar(&value, i < kFieldCount ? &out->buf[i] : &skipped))
+            {
+                return false;
+            }
+            if (i < kFieldCount)
+            {
+                out->values[i] = value;
+            }
+        }
+        return in.finish();
+    }
+
+    // 压缩器在首次使用时为预置字典建立哈希表
+    static const DictCompressor &compressor()
+    {
+        static const DictCompressor instance(RECORD_DICT);
+        return instance;
+    }
+
+    // 字段头是否带标记位: Decimal/Date 字段和带字典标记的 Text 字段带, 普通 Text 字段不带
+    static constexpr bool tagged(size_t i)
+    {
+        return Schema::kFields[i].type != FieldType::Text || (Schema::kFields[i].flags & FIELD_INTERN_FLAGS);
+    }
+
+    static Encoded classify(size_t i, std::string_view value, const Ref &ref)
+    {
+        FieldType type = Schema::kFields[i].type;
+        Encoded e;
+        if (type == FieldType::Text && !ref.ref.empty() && tagged(i))
+        {
+            size_t rest = value.size() - ref.prefixSize;
+            e.tag = kTagRef;
+            e.size = Varint::size(kTagRef) + ref.ref.size() + Varint::size(rest) + rest;
+        }
+        else if (type == FieldType::Decimal && FieldFormat::parseDecimal(value, &e.number, &e.scale))
+        {
+            e.tag = kTagDecimal;
+            e.size = Varint::size((e.scale << 2) | kTagDecimal) + Varint::size(Varint::zigzag(e.number));
+        }
+        else if (type == FieldType::Date && FieldFormat::parseDate(value, &e.number))
+        {
+            e.tag = kTagDate;
+            e.size = Varint::size(kTagDate) + Varint::size(Varint::zigzag(e.number));
+        }
+        else
+        {
+            uint64_t head = tagged(i) ? (value.size() << 2) | kTagText : value.size();
+            e.size = Varint::size(head) + value.size();
+        }
+        return e;
+    }
+
+};
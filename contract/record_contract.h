@@ -0,0 +1,2725 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "xchain/crypto.h"
+#include "xchain/xchain.h"
+
+#include "bloom_filter.h"
+#include "call_meter.h"
+#include "cursor.h"
+#include "json_reader.h"
+#include "json_writer.h"
+#include "merkle_tree.h"
+#include "ngram_index.h"
+#include "record_codec.h"
+#include "varint.h"
+
+// 各部门存证的公共实现: 参数提取、必填校验、序列化和读写账本
+// 全部账本键(字典除外)都带有构造时指定的命名空间前缀, 多个部门可以共存于同一个合约
+// Schema 需提供:
+//   kSchemaId - 记录编码中的结构编号, 各部门互不相同
+//   kAgency   - 部门名, 用于变更事件
+//   kFields   - 除主键 userid 以外的全部必填字段, 按存储顺序排列
+// 每个公开方法的第一个参数 method 为调用它的合约入口方法名, 账本读写次数、字节数和遍历步数按入口方法统计,
+// 见 CallMeter, 累计值由 queryCallStats 查询
+// 可选:
+//   kCompressed - 为true时用 record_dict.h 中的预置字典压缩存储的记录
+template <class Schema>
+class RecordStore
+{
+public:
+    // ns 为本部门账本键的前缀, 单部门合约为空
+    explicit RecordStore(xchain::Context *ctx, const std::string &ns = std::string())
+        : OWNER_KEY(ns + "Owner"), RECORD_KEY(ns + "R_"), INDEX_KEY(ns + "I_"), DIGEST_KEY(ns + "H_"),
+          SEQUENCE_KEY(ns + "Seq"), LOG_KEY(ns + "Q_"), READY_KEY(ns + "Ready"),
+          AGGREGATE_KEY(ns + "A_"), CONTRIBUTION_KEY(ns + "C_"), REVISION_KEY(ns + "V_"),
+          EXPIRY_KEY(ns + "E_"), REGION_KEY(ns + "G_"), _ctx(ctx), _merkle(ns), _bloom(ns), _ngrams(ns)
+    {
+    }
+
+    // 经由统计账本访问的上下文
+    xchain::Context *context()
+    {
+        return &_ctx;
+    }
+
+protected:
+    using Codec = RecordCodec<Schema>;
+    static constexpr size_t kFieldCount = Codec::kFieldCount;
+    static constexpr std::string_view USERID = "userid";
+
+    // 字段值, 指向调用参数或存储值中的字符串, 只在本次调用内有效
+    using Values = typename Codec::Values;
+
+    // 查询结果中要输出的字段集合, 第i位对应 kFields[i]
+    using FieldMask = uint64_t;
+    static_assert(kFieldCount < 64, "too many fields for FieldMask");
+    static constexpr FieldMask ALL_FIELDS = (FieldMask(1) << kFieldCount) - 1;
+
+    // 单次批量写入/查询允许的最大记录数
+    static constexpr size_t MAX_BATCH_SIZE = 1000;
+    // 按索引查询时单次返回的最大记录数
+    static constexpr size_t MAX_INDEX_RESULTS = 100;
+    // 分页列举的默认和最大每页条数
+    static constexpr size_t DEFAULT_PAGE_SIZE = 20;
+    static constexpr size_t MAX_PAGE_SIZE = 100;
+
+    // define the key prefix of buckets
+    const std::string OWNER_KEY;
+    const std::string RECORD_KEY;
+    const std::string INDEX_KEY;
+    const std::string DIGEST_KEY;
+    const std::string SEQUENCE_KEY;
+    const std::string LOG_KEY;
+    // 存在时表示全部记录都已计入派生结构和各项索引: 初始化时没有记录, 或 reindexRecords 已完成
+    const std::string READY_KEY;
+    const std::string AGGREGATE_KEY;
+    const std::string CONTRIBUTION_KEY;
+    const std::string REVISION_KEY;
+    const std::string EXPIRY_KEY;
+    const std::string REGION_KEY;
+    // 字典按内容寻址, 由同一合约中的各部门共享
+    const std::string DICT_KEY = "D_";
+
+    // 内容摘要长度: 截取 SHA-256 的前16字节
+    static constexpr size_t DIGEST_SIZE = 16;
+
+    // 短于此长度的取值直接存在记录中, 引用字典反而更长
+    static constexpr size_t MIN_INTERN_SIZE = 16;
+
+    // 汇总计数分散到的分块数, 同一userid总落在同一分块, 同一分组的汇总键不再是所有写入共用的键
+    // 分块只去掉了汇总本身的冲突, 并不能让并发写入互不冲突: 每次写入仍要更新全局的 Seq(变更日志序号)、
+    // Root 和 Merkle 树靠近根的节点, 这些键上的写入依然逐个串行
+    static constexpr size_t AGGREGATE_SHARDS = 8;
+    // 总和按定点数累计的小数位数, 更多的小数位截断
+    static constexpr uint64_t SUM_SCALE = 4;
+
+    // 每隔多少个版本存一次完整记录, 读取任一历史版本最多顺序读这么多个修订
+    static constexpr uint64_t KEYFRAME_INTERVAL = 16;
+
+    // 单条记录的写入结果
+    enum WriteStatus
+    {
+        WRITE_FAILED,
+        WRITE_OK,
+        WRITE_UNCHANGED, // 内容与账本中相同, 未写入
+    };
+
+    // 是否有字段带有指定的 FieldFlag
+    static constexpr bool hasFieldFlag(unsigned flag)
+    {
+        for (const FieldSpec &f : Schema::kFields)
+        {
+            if (f.flags & flag)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 带有指定 FieldFlag 的第一个字段的下标, 没有时为 kFieldCount; 用于每个 Schema 至多一个的标记
+    static constexpr size_t flaggedField(unsigned flag)
+    {
+        for (size_t i = 0; i < kFieldCount; i++)
+        {
+            if (Schema::kFields[i].flags & flag)
+            {
+                return i;
+            }
+        }
+        return kFieldCount;
+    }
+
+    // check if caller is the owner of this contract
+    bool isOwner(xchain::Context *ctx, const std::string &caller)
+    {
+        std::string owner;
+        if (!ctx->get_object(OWNER_KEY, &owner))
+        {
+            return false;
+        }
+        return (owner == caller);
+    }
+
+    // 返回第一个缺失的必填字段名, 齐全时返回空
+    static std::string_view missingField(std::string_view userid, const Values &values)
+    {
+        if (userid.empty())
+        {
+            return USERID;
+        }
+        for (size_t i = 0; i < kFieldCount; i++)
+        {
+            if (values[i].empty())
+            {
+                return Schema::kFields[i].name;
+            }
+        }
+        return std::string_view();
+    }
+
+    // 字段名对应的下标, 不是记录字段时返回 kFieldCount
+    static size_t fieldIndex(std::string_view name)
+    {
+        for (size_t i = 0; i < kFieldCount; i++)
+        {
+            if (name == Schema::kFields[i].name)
+            {
+                return i;
+            }
+        }
+        return kFieldCount;
+    }
+
+    // 遍历一次调用参数, 按字段名取出userid和各字段的值, 字段名本身不产生分配
+    // 返回第一个缺失的必填参数名, 参数齐全时返回空
+    std::string_view bindArgs(xchain::Context *ctx, std::string_view *userid, Values *values)
+    {
+        for (const auto &kv : ctx->args())
+        {
+            std::string_view key = kv.first;
+            if (key == USERID)
+            {
+                *userid = kv.second;
+                continue;
+            }
+            size_t i = fieldIndex(key);
+            if (i < kFieldCount)
+            {
+                (*values)[i] = kv.second;
+            }
+        }
+        return missingField(*userid, *values);
+    }
+
+    // 批量写入中的一条记录, 字段值指向请求原文或 buf 中解码后的字符串
+    struct PendingRecord
+    {
+        std::string_view userid;
+        Values values;
+        std::array<std::string, kFieldCount + 1> buf;
+    };
+
+    // 从json对象中取出一条记录, 未知的键忽略
+    static bool bindObject(JsonReader *in, PendingRecord *rec)
+    {
+        if (!in->beginObject())
+        {
+            return false;
+        }
+        std::string_view key;
+        std::string keyBuf;
+        while (in->next())
+        {
+            if (!in->key(&key, &keyBuf))
+            {
+                return false;
+            }
+            if (key == USERID)
+            {
+                if (!in->scalar(&rec->userid, &rec->buf[kFieldCount]))
+                {
+                    return false;
+                }
+                continue;
+            }
+            size_t i = fieldIndex(key);
+            bool ok = i < kFieldCount ? in->scalar(&rec->values[i], &rec->buf[i]) : in->skip();
+            if (!ok)
+            {
+                return false;
+            }
+        }
+        return !in->failed();
+    }
+
+    // 查询返回的json在不需转义时的长度, 用于预留缓冲区
+    static size_t jsonSize(std::string_view userid, const Values &values, FieldMask mask = ALL_FIELDS)
+    {
+        size_t size = JsonWriter::kObjectOverhead + JsonWriter::fieldSize(USERID, userid);
+        for (size_t i = 0; i < kFieldCount; i++)
+        {
+            if (mask & (FieldMask(1) << i))
+            {
+                size += JsonWriter::fieldSize(Schema::kFields[i].name, values[i]);
+            }
+        }
+        return size;
+    }
+
+    // 按字段顺序输出 mask 中的字段, 末尾总是附加userid
+    static void writeJson(JsonWriter *json, std::string_view userid, const Values &values,
+                          FieldMask mask = ALL_FIELDS)
+    {
+        json->beginObject();
+        for (size_t i = 0; i < kFieldCount; i++)
+        {
+            if (mask & (FieldMask(1) << i))
+            {
+                json->field(Schema::kFields[i].name, values[i]);
+            }
+        }
+        json->field(USERID, userid);
+        json->endObject();
+    }
+
+    // 账本中的一条记录及其解码结果, 解码结果引用 data, 因此整体不可移动
+    struct StoredRecord
+    {
+        std::string data;
+        typename Codec::Decoded decoded;
+    };
+
+    // 按主键读取并解码记录, 不存在返回false, 记录损坏时 *corrupted 置为true
+    bool loadRecord(xchain::Context *ctx, const std::string &key, StoredRecord *rec, bool *corrupted)
+    {
+        *corrupted = false;
+        if (!ctx->get_object(key, &rec->data))
+        {
+            return false;
+        }
+        if (!decodeRecord(ctx, rec))
+        {
+            *corrupted = true;
+            return false;
+        }
+        return true;
+    }
+
+    // 解码 rec->data 并查字典补全引用的字段
+    bool decodeRecord(xchain::Context *ctx, StoredRecord *rec)
+    {
+        if (!Codec::decode(rec->data, &rec->decoded))
+        {
+            return false;
+        }
+        if constexpr (hasFieldFlag(FIELD_INTERN_FLAGS))
+        {
+            typename Codec::Decoded &d = rec->decoded;
+            for (size_t i = 0; i < kFieldCount; i++)
+            {
+                if (d.refs[i].empty())
+                {
+                    continue;
+                }
+                const std::string *prefix = dictLookup(ctx, d.refs[i]);
+                if (!prefix)
+                {
+                    return false;
+                }
+                if (d.values[i].empty())
+                {
+                    d.values[i] = *prefix;
+                    continue;
+                }
+                d.buf[i].reserve(prefix->size() + d.values[i].size());
+                d.buf[i].assign(*prefix).append(d.values[i]);
+                d.values[i] = d.buf[i];
+            }
+        }
+        return true;
+    }
+
+    // 旧版json记录在输出全部字段(或无法解析)时原样返回
+    static bool rawLegacy(const StoredRecord &rec, FieldMask mask)
+    {
+        return !rec.decoded.legacyJson.empty() && (mask == ALL_FIELDS || !rec.decoded.hasValues);
+    }
+
+    static size_t jsonSize(std::string_view userid, const StoredRecord &rec, FieldMask mask)
+    {
+        if (rawLegacy(rec, mask))
+        {
+            return rec.decoded.legacyJson.size();
+        }
+        return jsonSize(userid, rec.decoded.values, mask);
+    }
+
+    // 二进制记录在此时才渲染成json
+    static void writeJson(JsonWriter *json, std::string_view userid, const StoredRecord &rec, FieldMask mask)
+    {
+        if (rawLegacy(rec, mask))
+        {
+            json->raw(rec.decoded.legacyJson);
+            return;
+        }
+        writeJson(json, userid, rec.decoded.values, mask);
+    }
+
+    // 读取字段投影参数 fields: 逗号分隔的字段名, 缺省时输出全部字段
+    // userid 总是输出; 有未知字段名时已返回错误
+    static bool projection(xchain::Context *ctx, FieldMask *mask)
+    {
+        const std::string &fields = ctx->arg("fields");
+        if (fields.empty())
+        {
+            *mask = ALL_FIELDS;
+            return true;
+        }
+        *mask = 0;
+        std::string_view rest = fields;
+        while (!rest.empty())
+        {
+            size_t comma = rest.find(',');
+            std::string_view name = rest.substr(0, comma);
+            rest = comma == std::string_view::npos ? std::string_view() : rest.substr(comma + 1);
+            while (!name.empty() && name.front() == ' ')
+            {
+                name.remove_prefix(1);
+            }
+            while (!name.empty() && name.back() == ' ')
+            {
+                name.remove_suffix(1);
+            }
+            if (name.empty() || name == USERID)
+            {
+                continue;
+            }
+            size_t i = fieldIndex(name);
+            if (i == kFieldCount)
+            {
+                ctx->error(std::string("unknown field '").append(name).append("'"));
+                return false;
+            }
+            *mask |= FieldMask(1) << i;
+        }
+        return true;
+    }
+
+    std::string recordKey(std::string_view userid) const
+    {
+        std::string key;
+        key.reserve(RECORD_KEY.size() + userid.size());
+        key.append(RECORD_KEY).append(userid);
+        return key;
+    }
+
+    // 内容摘要键: H_<userid>, 值为记录字段部分的摘要, 与 R_<userid> 一同写入
+    std::string digestKey(std::string_view userid) const
+    {
+        std::string key;
+        key.reserve(DIGEST_KEY.size() + userid.size());
+        key.append(DIGEST_KEY).append(userid);
+        return key;
+    }
+
+    static std::string contentDigest(const std::string &fields)
+    {
+        std::string digest = xchain::crypto::sha256(fields);
+        digest.resize(DIGEST_SIZE);
+        return digest;
+    }
+
+    // 字典键: D_<引用>, 引用为取值 SHA-256 的前 kRefSize 字节, 值为原文
+    // 字典项写入后不再修改, 同一次调用内查过的项缓存在 _dict 中
+    std::string dictKey(std::string_view ref) const
+    {
+        std::string key;
+        key.reserve(DICT_KEY.size() + ref.size());
+        key.append(DICT_KEY).append(ref);
+        return key;
+    }
+
+    // 按引用查字典, 返回的指针在本次调用内有效; 字典项不存在返回空
+    const std::string *dictLookup(xchain::Context *ctx, std::string_view ref)
+    {
+        auto it = _dict.find(ref);
+        if (it != _dict.end())
+        {
+            return &it->second;
+        }
+        std::string value;
+        if (!ctx->get_object(dictKey(ref), &value))
+        {
+            return nullptr;
+        }
+        return &_dict.emplace(std::string(ref), std::move(value)).first->second;
+    }
+
+    // 把取值存入字典(已存在则复用), 返回其引用; 引用冲突或写入失败时返回空, 调用方应直接存原文
+    std::string_view intern(xchain::Context *ctx, std::string_view value)
+    {
+        std::string ref = xchain::crypto::sha256(std::string(value));
+        ref.resize(Codec::kRefSize);
+        const std::string *stored = dictLookup(ctx, ref);
+        if (!stored)
+        {
+            if (!ctx->put_object(dictKey(ref), std::string(value)))
+            {
+                return std::string_view();
+            }
+            stored = &_dict.emplace(ref, std::string(value)).first->second;
+        }
+        if (*stored != value)
+        {
+            return std::string_view();
+        }
+        // 返回缓存中的键, 在本次调用内保持有效
+        return _dict.find(ref)->first;
+    }
+
+    // 二级索引键: I_<字段名>\0<字段值>\0<userid>, 值为userid
+    // 同一字段值的全部记录连续排列, 按字段值查询时做一次前缀扫描
+    std::string indexPrefix(size_t field, std::string_view value) const
+    {
+        std::string_view name = Schema::kFields[field].name;
+        std::string key;
+        key.reserve(INDEX_KEY.size() + name.size() + value.size() + 24);
+        key.append(INDEX_KEY).append(name).append(1, '\0').append(value).append(1, '\0');
+        return key;
+    }
+
+    // 读取分页参数 limit, 缺省为 DEFAULT_PAGE_SIZE, 不合法时已返回错误
+    static bool pageLimit(xchain::Context *ctx, size_t *limit)
+    {
+        const std::string &arg = ctx->arg("limit");
+        if (arg.empty())
+        {
+            *limit = DEFAULT_PAGE_SIZE;
+            return true;
+        }
+        size_t v = 0;
+        for (char c : arg)
+        {
+            if (c < '0' || c > '9' || v > MAX_PAGE_SIZE)
+            {
+                v = 0;
+                break;
+            }
+            v = v * 10 + static_cast<size_t>(c - '0');
+        }
+        if (v == 0 || v > MAX_PAGE_SIZE)
+        {
+            ctx->error("'limit' must be between 1 and " + std::to_string(MAX_PAGE_SIZE));
+            return false;
+        }
+        *limit = v;
+        return true;
+    }
+
+    // 布尔参数, 接受 true/1
+    static bool flagArg(xchain::Context *ctx, const std::string &name)
+    {
+        const std::string &arg = ctx->arg(name);
+        return arg == "true" || arg == "1";
+    }
+
+public:
+    void initializeOwner(std::string_view method)
+    {
+        CallMeter meter(&_ctx, std::string(method));
+        // 获取合约上下文对象
+        xchain::Context *ctx = this->context();
+        // 从合约上下文中获取合约参数, 由合约部署者指定具有写入权限的address
+        const std::string &owner = ctx->arg("owner");
+        if (owner.empty())
+        {
+            ctx->error("missing owner address");
+            return;
+        }
+        // 将具有写入权限的owner地址记录在区块链账本中
+        ctx->put_object(OWNER_KEY, owner);
+        // 还没有记录时派生结构从一开始就是完整的, 否则须由 reindexRecords 补齐
+        std::string end = RECORD_KEY;
+        end.back()++;
+        if (!ctx->new_iterator(RECORD_KEY, end)->next())
+        {
+            ctx->put_object(READY_KEY, "1");
+        }
+        ctx->ok("success");
+    }
+
+protected:
+    // 校验发起者是具有写权限的owner, 失败时已返回错误
+    bool checkWriter(xchain::Context *ctx)
+    {
+        // 获取发起者身份
+        const std::string &caller = ctx->initiator();
+        if (caller.empty())
+        {
+            ctx->error("missing initiator");
+            return false;
+        }
+        // 如果写操作发起者不是具有写权限的用户，则无权写入
+        if (!isOwner(ctx, caller))
+        {
+            ctx->error(
+                "permission check failed, only the owner can add score record");
+            return false;
+        }
+        return true;
+    }
+
+    // 把一条已校验的记录写入账本, 同时维护二级索引和内容摘要
+    // 先只读出摘要比较, 内容未变时不读旧记录也不写入, 返回 WRITE_UNCHANGED
+    WriteStatus writeRecord(xchain::Context *ctx, std::string_view userid, const Values &values)
+    {
+        std::string fields = Codec::encodeFields(values);
+        std::string digest = contentDigest(fields);
+        std::string stored;
+        if (ctx->get_object(digestKey(userid), &stored) && stored == digest)
+        {
+            return WRITE_UNCHANGED;
+        }
+        StoredRecord old;
+        bool corrupted;
+        bool exists = loadRecord(ctx, recordKey(userid), &old, &corrupted);
+        uint64_t version;
+        return putRecord(ctx, userid, values, fields, digest, exists ? &old : nullptr, &version);
+    }
+
+    // 写入记录、摘要和变化的索引项, old 为已读出的旧记录, 不存在时为空; 损坏的旧记录按不存在处理
+    // *version 为写入后的版本号
+    WriteStatus putRecord(xchain::Context *ctx, std::string_view userid, const Values &values,
+                          const std::string &fields, const std::string &digest, const StoredRecord *old,
+                          uint64_t *version)
+    {
+        const Values *oldValues = old && old->decoded.hasValues ? &old->decoded.values : nullptr;
+        if (!updateIndexes(ctx, userid, oldValues, values) ||
+            !updateExpiry(ctx, userid, oldValues, values) ||
+            !updateRegion(ctx, userid, oldValues, values) ||
+            !updateSearch(ctx, userid, oldValues, values))
+        {
+            return WRITE_FAILED;
+        }
+        *version = old ? old->decoded.version + 1 : 1;
+        std::string stored;
+        if constexpr (hasFieldFlag(FIELD_INTERN_FLAGS))
+        {
+            // 带字典标记的字段存入字典, 记录中只留引用
+            typename Codec::Refs refs;
+            for (size_t i = 0; i < kFieldCount; i++)
+            {
+                unsigned flags = Schema::kFields[i].flags;
+                if (!(flags & FIELD_INTERN_FLAGS))
+                {
+                    continue;
+                }
+                size_t size = (flags & FIELD_INTERNED) ? values[i].size() : regionPrefixSize(values[i]);
+                if (size < MIN_INTERN_SIZE)
+                {
+                    continue;
+                }
+                refs[i].ref = intern(ctx, values[i].substr(0, size));
+                refs[i].prefixSize = size;
+            }
+            stored = Codec::encode(*version, Codec::encodeFields(values, refs));
+        }
+        else
+        {
+            stored = Codec::encode(*version, fields);
+        }
+        if (!ctx->put_object(recordKey(userid), stored) ||
+            !ctx->put_object(digestKey(userid), digest))
+        {
+            return WRITE_FAILED;
+        }
+        uint64_t seq;
+        if (!appendLog(ctx, userid, *version, &seq) ||
+            !appendRevision(ctx, userid, *version, seq, values, stored, old))
+        {
+            return WRITE_FAILED;
+        }
+        if (!updateDerived(ctx, userid, values))
+        {
+            return WRITE_FAILED;
+        }
+        emitChange(ctx, userid, *version, seq, digest);
+        return WRITE_OK;
+    }
+
+    // 维护 FIELD_INDEXED 字段的二级索引, old 为旧记录的字段值, 没有时为空; 只改动取值变化的字段
+    // 升级前写入的记录可能还没有索引项, 删除不存在的旧项没有影响
+    bool updateIndexes(xchain::Context *ctx, std::string_view userid, const Values *old, const Values &values)
+    {
+        if constexpr (hasFieldFlag(FIELD_INDEXED))
+        {
+            for (size_t i = 0; i < kFieldCount; i++)
+            {
+                if (!(Schema::kFields[i].flags & FIELD_INDEXED) || (old && (*old)[i] == values[i]))
+                {
+                    continue;
+                }
+                if (old)
+                {
+                    ctx->delete_object(indexPrefix(i, (*old)[i]).append(userid));
+                }
+                if (!ctx->put_object(indexPrefix(i, values[i]).append(userid), std::string(userid)))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // 更新由记录内容派生的结构: Merkle 叶子、布隆过滤器和分组汇总, 对同一内容重复调用不产生变化
+    // 叶子取查询方法返回的json, 第三方拿到查询结果即可自行算出叶子
+    bool updateDerived(xchain::Context *ctx, std::string_view userid, const Values &values)
+    {
+        JsonWriter json(jsonSize(userid, values));
+        writeJson(&json, userid, values);
+        return _merkle.update(ctx, userid, MerkleTree::leafHash(json.finish())) && _bloom.add(ctx, userid) &&
+               updateAggregates(ctx, userid, values);
+    }
+
+    // 到期索引键: E_<Fixed64 到期日><userid>, 值为userid; 到期日为距1970-01-01的天数, 翻转符号位后按日期排序
+    // 每天一个桶, 同一天到期的记录连续排列, 按日期区间查询时做一次范围扫描
+    std::string expiryKey(int64_t days, std::string_view userid) const
+    {
+        std::string key;
+        key.reserve(EXPIRY_KEY.size() + Fixed64::kSize + userid.size());
+        key.append(EXPIRY_KEY);
+        Fixed64::put(&key, static_cast<uint64_t>(days) ^ (uint64_t(1) << 63));
+        key.append(userid);
+        return key;
+    }
+
+    // 按期限字段中解析出的到期日维护到期索引, old 为旧记录的字段值, 没有时为空
+    // 期限中没有日期(如 "长期")的记录不进入索引
+    bool updateExpiry(xchain::Context *ctx, std::string_view userid, const Values *old, const Values &values)
+    {
+        if constexpr (flaggedField(FIELD_EXPIRY) < kFieldCount)
+        {
+            constexpr size_t i = flaggedField(FIELD_EXPIRY);
+            int64_t days;
+            if (old && (*old)[i] == values[i])
+            {
+                return true;
+            }
+            if (old && FieldFormat::parseExpiry((*old)[i], &days))
+            {
+                ctx->delete_object(expiryKey(days, userid));
+            }
+            if (FieldFormat::parseExpiry(values[i], &days) &&
+                !ctx->put_object(expiryKey(days, userid), std::string(userid)))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 行政区划前缀: G_ 之后每一级加 \x01 结尾, 某一级及其下全部层级的记录都以它开头, 按任一级查询都是一次前缀扫描
+    std::string regionPrefix(const RegionPath &levels, size_t count) const
+    {
+        std::string key(REGION_KEY);
+        for (size_t i = 0; i < count; i++)
+        {
+            key.append(levels[i]).append(1, '\x01');
+        }
+        return key;
+    }
+
+    // 行政区划索引键: 区划前缀 + \0 + userid, 值为userid
+    std::string regionKey(std::string_view address, std::string_view userid) const
+    {
+        RegionPath levels;
+        size_t count = regionLevels(address, &levels);
+        if (count == 0)
+        {
+            return std::string();
+        }
+        return regionPrefix(levels, count).append(1, '\0').append(userid);
+    }
+
+    // 按地址字段解析出的行政区划维护索引, old 为旧记录的字段值, 没有时为空; 识别不出区划的地址不进入索引
+    bool updateRegion(xchain::Context *ctx, std::string_view userid, const Values *old, const Values &values)
+    {
+        if constexpr (flaggedField(FIELD_REGION) < kFieldCount)
+        {
+            constexpr size_t i = flaggedField(FIELD_REGION);
+            std::string key = regionKey(values[i], userid);
+            if (old)
+            {
+                std::string oldKey = regionKey((*old)[i], userid);
+                if (oldKey == key)
+                {
+                    return true;
+                }
+                if (!oldKey.empty())
+                {
+                    ctx->delete_object(oldKey);
+                }
+            }
+            if (!key.empty() && !ctx->put_object(key, std::string(userid)))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 全部 FIELD_SEARCHED 字段的二元组
+    static std::vector<std::string> searchTerms(const Values &values)
+    {
+        std::vector<std::string_view> texts;
+        for (size_t i = 0; i < kFieldCount; i++)
+        {
+            if (Schema::kFields[i].flags & FIELD_SEARCHED)
+            {
+                texts.push_back(values[i]);
+            }
+        }
+        return NgramIndex::terms(texts);
+    }
+
+    // 按 FIELD_SEARCHED 字段维护关键词索引, old 为旧记录的字段值, 没有时为空; 只增删有变化的二元组
+    bool updateSearch(xchain::Context *ctx, std::string_view userid, const Values *old, const Values &values)
+    {
+        if constexpr (hasFieldFlag(FIELD_SEARCHED))
+        {
+            bool changed = !old;
+            for (size_t i = 0; i < kFieldCount && !changed; i++)
+            {
+                changed = (Schema::kFields[i].flags & FIELD_SEARCHED) && (*old)[i] != values[i];
+            }
+            if (!changed)
+            {
+                return true;
+            }
+            return _ngrams.update(ctx, userid, old ? searchTerms(*old) : std::vector<std::string>(),
+                                  searchTerms(values));
+        }
+        return true;
+    }
+
+    // 各 FIELD_SUMMED 字段的定点数值, 按字段下标存放
+    using Sums = std::array<int64_t, kFieldCount>;
+
+    // 换算为 SUM_SCALE 位小数的定点数, 不是规范数值或超出范围时按0计
+    static int64_t scaledValue(std::string_view value)
+    {
+        int64_t mantissa;
+        uint64_t scale;
+        if (!FieldFormat::parseDecimal(value, &mantissa, &scale))
+        {
+            return 0;
+        }
+        for (; scale > SUM_SCALE; scale--)
+        {
+            mantissa /= 10;
+        }
+        for (; scale < SUM_SCALE; scale++)
+        {
+            if (mantissa > INT64_MAX / 10 || mantissa < INT64_MIN / 10)
+            {
+                return 0;
+            }
+            mantissa *= 10;
+        }
+        return mantissa;
+    }
+
+    // 一条记录计入汇总的内容, 存于 C_<userid>, 下次写入时据此从旧分组中减去
+    // 编码: 每个分组字段 varint(长度)+取值, 之后每个求和字段 zigzag varint
+    static std::string contribution(const Values &values)
+    {
+        std::string out;
+        for (size_t i = 0; i < kFieldCount; i++)
+        {
+            if (Schema::kFields[i].flags & FIELD_GROUPED)
+            {
+                Varint::put(&out, values[i].size());
+                out.append(values[i]);
+            }
+        }
+        for (size_t i = 0; i < kFieldCount; i++)
+        {
+            if (Schema::kFields[i].flags & FIELD_SUMMED)
+            {
+                Varint::put(&out, Varint::zigzag(scaledValue(values[i])));
+            }
+        }
+        return out;
+    }
+
+    static bool parseContribution(std::string_view in, Values *groups, Sums *sums)
+    {
+        size_t pos = 0;
+        uint64_t v;
+        for (size_t i = 0; i < kFieldCount; i++)
+        {
+            if (Schema::kFields[i].flags & FIELD_GROUPED)
+            {
+                if (!Varint::get(in, &pos, &v) || v > in.size() - pos)
+                {
+                    return false;
+                }
+                (*groups)[i] = in.substr(pos, v);
+                pos += v;
+            }
+        }
+        for (size_t i = 0; i < kFieldCount; i++)
+        {
+            (*sums)[i] = 0;
+            if (Schema::kFields[i].flags & FIELD_SUMMED)
+            {
+                if (!Varint::get(in, &pos, &v))
+                {
+                    return false;
+                }
+                (*sums)[i] = Varint::unzigzag(v);
+            }
+        }
+        return pos == in.size();
+    }
+
+    // 汇总键: A_<字段名>\0<字段值>\0<分块号>, 值为 zigzag varint 的记录数, 之后每个求和字段一个 zigzag varint
+    std::string aggregateKey(size_t field, std::string_view value, size_t shard) const
+    {
+        std::string_view name = Schema::kFields[field].name;
+        std::string key;
+        key.reserve(AGGREGATE_KEY.size() + name.size() + value.size() + 3);
+        key.append(AGGREGATE_KEY).append(name).append(1, '\0').append(value).append(1, '\0');
+        key += static_cast<char>(shard);
+        return key;
+    }
+
+    // 读出一个分块的记录数和总和, 不存在时为0
+    bool loadAggregate(xchain::Context *ctx, const std::string &key, int64_t *count, Sums *sums)
+    {
+        *count = 0;
+        sums->fill(0);
+        std::string stored;
+        if (!ctx->get_object(key, &stored))
+        {
+            return true;
+        }
+        size_t pos = 0;
+        uint64_t v;
+        if (!Varint::get(stored, &pos, &v))
+        {
+            return false;
+        }
+        *count = Varint::unzigzag(v);
+        for (size_t i = 0; i < kFieldCount; i++)
+        {
+            if (Schema::kFields[i].flags & FIELD_SUMMED)
+            {
+                if (!Varint::get(stored, &pos, &v))
+                {
+                    return false;
+                }
+                (*sums)[i] = Varint::unzigzag(v);
+            }
+        }
+        return pos == stored.size();
+    }
+
+    // 把 sign 倍的 (count, sums) 加到字段 field 取值为 value 的分块上, 减到全为0时删除该键
+    bool addAggregate(xchain::Context *ctx, size_t field, std::string_view value, size_t shard, int64_t count,
+                      const Sums &sums, int64_t sign)
+    {
+        std::string key = aggregateKey(field, value, shard);
+        int64_t total;
+        Sums totals;
+        if (!loadAggregate(ctx, key, &total, &totals))
+        {
+            return false;
+        }
+        total += count * sign;
+        bool empty = total == 0;
+        std::string out;
+        Varint::put(&out, Varint::zigzag(total));
+        for (size_t i = 0; i < kFieldCount; i++)
+        {
+            if (Schema::kFields[i].flags & FIELD_SUMMED)
+            {
+                totals[i] += sums[i] * sign;
+                empty = empty && totals[i] == 0;
+                Varint::put(&out, Varint::zigzag(totals[i]));
+            }
+        }
+        if (empty)
+        {
+            ctx->delete_object(key);
+            return true;
+        }
+        return ctx->put_object(key, out);
+    }
+
+    // 把记录计入各分组字段的汇总, 先从旧贡献所在的分组中减去; 汇总键分块的作用范围见 AGGREGATE_SHARDS
+    bool updateAggregates(xchain::Context *ctx, std::string_view userid, const Values &values)
+    {
+        if constexpr (hasFieldFlag(FIELD_GROUPED))
+        {
+            std::string next = contribution(values);
+            std::string key = std::string(CONTRIBUTION_KEY).append(userid);
+            std::string prev;
+            bool counted = ctx->get_object(key, &prev);
+            if (counted && prev == next)
+            {
+                return true;
+            }
+            Values oldGroups;
+            Sums oldSums;
+            if (counted && !parseContribution(prev, &oldGroups, &oldSums))
+            {
+                return false;
+            }
+            Values newGroups;
+            Sums newSums;
+            parseContribution(next, &newGroups, &newSums);
+            size_t shard = static_cast<size_t>(fnv1a(userid) % AGGREGATE_SHARDS);
+            for (size_t i = 0; i < kFieldCount; i++)
+            {
+                if (!(Schema::kFields[i].flags & FIELD_GROUPED))
+                {
+                    continue;
+                }
+                // 分组不变时只累加总和的差值, 一个分块只读写一次
+                if (counted && oldGroups[i] == newGroups[i])
+                {
+                    Sums delta;
+                    for (size_t k = 0; k < kFieldCount; k++)
+                    {
+                        delta[k] = newSums[k] - oldSums[k];
+                    }
+                    if (!addAggregate(ctx, i, newGroups[i], shard, 0, delta, 1))
+                    {
+                        return false;
+                    }
+                    continue;
+                }
+                if ((counted && !addAggregate(ctx, i, oldGroups[i], shard, 1, oldSums, -1)) ||
+                    !addAggregate(ctx, i, newGroups[i], shard, 1, newSums, 1))
+                {
+                    return false;
+                }
+            }
+            return ctx->put_object(key, next);
+        }
+        return true;
+    }
+
+    // 派生结构和各项索引是否已覆盖全部记录, 同一次调用内只读一次
+    bool derivedReady(xchain::Context *ctx)
+    {
+        if (_ready < 0)
+        {
+            std::string stored;
+            _ready = ctx->get_object(READY_KEY, &stored) ? 1 : 0;
+        }
+        return _ready == 1;
+    }
+
+    // 记录是否存在: 过滤器可用时先排除一定不存在的userid, 其余只读16字节的摘要而不读记录
+    // 内容摘要上线前写入的记录没有摘要, 再读一次记录本身
+    bool recordExists(xchain::Context *ctx, std::string_view userid)
+    {
+        if (derivedReady(ctx) && !_bloom.mayContain(ctx, userid))
+        {
+            return false;
+        }
+        std::string stored;
+        return ctx->get_object(digestKey(userid), &stored) || ctx->get_object(recordKey(userid), &stored);
+    }
+
+    // 变更日志键: Q_<序号>, 序号为8字节大端整数, 日志按序号排列; 值为 varint(版本号) 加 userid
+    // 最新序号存于 Seq, 同一次调用内缓存, 批量写入时只读一次
+    std::string logKey(uint64_t seq) const
+    {
+        std::string key;
+        key.reserve(LOG_KEY.size() + Fixed64::kSize);
+        key.append(LOG_KEY);
+        Fixed64::put(&key, seq);
+        return key;
+    }
+
+    // 为一次写入分配下一个序号并追加日志项
+    bool appendLog(xchain::Context *ctx, std::string_view userid, uint64_t version, uint64_t *seq)
+    {
+        if (!_sequenceLoaded)
+        {
+            std::string stored;
+            if (ctx->get_object(SEQUENCE_KEY, &stored) && !Fixed64::get(stored, &_sequence))
+            {
+                return false;
+            }
+            _sequenceLoaded = true;
+        }
+        std::string entry;
+        Varint::put(&entry, version);
+        entry.append(userid);
+        std::string next;
+        Fixed64::put(&next, _sequence + 1);
+        if (!ctx->put_object(logKey(_sequence + 1), entry) || !ctx->put_object(SEQUENCE_KEY, next))
+        {
+            return false;
+        }
+        *seq = ++_sequence;
+        return true;
+    }
+
+    // 修订键: V_<userid>\0<Fixed64 版本号>, 同一记录的修订按版本连续排列, 只追加不修改
+    // 值: 1字节类型 + varint(变更日志序号) + 内容
+    //   REVISION_KEYFRAME: 内容为该版本存入 R_ 的记录原样, 沿用其压缩和字典引用
+    //   REVISION_DELTA:    varint(变化字段的位图) + 每个变化字段的 varint(长度)+取值, 相对上一版本
+    static constexpr char REVISION_KEYFRAME = 0;
+    static constexpr char REVISION_DELTA = 1;
+
+    std::string revisionKey(std::string_view userid, uint64_t version) const
+    {
+        std::string key;
+        key.reserve(REVISION_KEY.size() + userid.size() + 1 + Fixed64::kSize);
+        key.append(REVISION_KEY).append(userid).append(1, '\0');
+        Fixed64::put(&key, version);
+        return key;
+    }
+
+    static std::string keyframe(uint64_t seq, std::string_view record)
+    {
+        std::string entry;
+        entry.reserve(1 + Varint::size(seq) + record.size());
+        entry += REVISION_KEYFRAME;
+        Varint::put(&entry, seq);
+        entry.append(record);
+        return entry;
+    }
+
+    // 追加本次写入的修订, record 为写入 R_ 的值
+    // 只有改造前写入的json记录没有修订, 修改它时先以序号0补存旧版本的完整记录, 之后的版本都能重建;
+    // 写入后记录即为二进制编码, 因此每条记录至多补存一次, 其余修改不为此多读账本
+    // 版本号满 KEYFRAME_INTERVAL 或没有旧版本时存完整记录, 否则只存变化的字段
+    bool appendRevision(xchain::Context *ctx, std::string_view userid, uint64_t version, uint64_t seq,
+                        const Values &values, const std::string &record, const StoredRecord *old)
+    {
+        bool delta = old && old->decoded.hasValues;
+        if (delta && !old->decoded.legacyJson.empty() &&
+            !ctx->put_object(revisionKey(userid, version - 1), keyframe(0, old->data)))
+        {
+            return false;
+        }
+        if (!delta || (version - 1) % KEYFRAME_INTERVAL == 0)
+        {
+            return ctx->put_object(revisionKey(userid, version), keyframe(seq, record));
+        }
+        FieldMask changed = 0;
+        for (size_t i = 0; i < kFieldCount; i++)
+        {
+            if (old->decoded.values[i] != values[i])
+            {
+                changed |= FieldMask(1) << i;
+            }
+        }
+        std::string entry;
+        entry += REVISION_DELTA;
+        Varint::put(&entry, seq);
+        Varint::put(&entry, changed);
+        for (size_t i = 0; i < kFieldCount; i++)
+        {
+            if (changed & (FieldMask(1) << i))
+            {
+                Varint::put(&entry, values[i].size());
+                entry.append(values[i]);
+            }
+        }
+        return ctx->put_object(revisionKey(userid, version), entry);
+    }
+
+    // 重建出的一个历史版本, values 指向 fields
+    struct Revision
+    {
+        uint64_t version = 0;
+        uint64_t seq = 0;
+        std::array<std::string, kFieldCount> fields;
+
+        Values values() const
+        {
+            Values v;
+            for (size_t i = 0; i < kFieldCount; i++)
+            {
+                v[i] = fields[i];
+            }
+            return v;
+        }
+    };
+
+    // 从 from 之前最近的完整记录起顺序重建, 对 [from, to] 中能重建的每个版本按升序调用 visit(rev)
+    // 最多多读 KEYFRAME_INTERVAL-1 个修订; 没有保留的版本不会被访问; 修订损坏时返回false
+    template <class Visit>
+    bool replayRevisions(xchain::Context *ctx, std::string_view userid, uint64_t from, uint64_t to, Visit visit)
+    {
+        uint64_t base = from - (from - 1) % KEYFRAME_INTERVAL;
+        std::string prefix = revisionKey(userid, 0);
+        prefix.resize(prefix.size() - Fixed64::kSize);
+        auto it = ctx->new_iterator(revisionKey(userid, base), revisionKey(userid, to + 1));
+        Revision rev;
+        bool valid = false;
+        xchain::ElemType elem;
+        while (it->next())
+        {
+            uint64_t version;
+            uint64_t seq;
+            size_t pos = 1;
+            if (!it->get(&elem) || elem.key.size() != prefix.size() + Fixed64::kSize ||
+                !Fixed64::get(std::string_view(elem.key).substr(prefix.size()), &version) || elem.value.empty() ||
+                !Varint::get(elem.value, &pos, &seq))
+            {
+                return false;
+            }
+            std::string_view body = std::string_view(elem.value).substr(pos);
+            if (elem.value[0] == REVISION_KEYFRAME)
+            {
+                StoredRecord rec;
+                rec.data.assign(body);
+                if (!decodeRecord(ctx, &rec) || !rec.decoded.hasValues)
+                {
+                    return false;
+                }
+                for (size_t i = 0; i < kFieldCount; i++)
+                {
+                    rev.fields[i].assign(rec.decoded.values[i]);
+                }
+                valid = true;
+            }
+            else if (elem.value[0] != REVISION_DELTA)
+            {
+                return false;
+            }
+            else if (!valid || version != rev.version + 1)
+            {
+                // 前面的版本没有保留, 从下一个完整记录起才能重建
+                valid = false;
+            }
+            else if (!applyDelta(body, &rev))
+            {
+                return false;
+            }
+            rev.version = version;
+            rev.seq = seq;
+            if (valid && version >= from)
+            {
+                visit(rev);
+            }
+        }
+        return true;
+    }
+
+    static bool applyDelta(std::string_view in, Revision *rev)
+    {
+        size_t pos = 0;
+        uint64_t changed;
+        if (!Varint::get(in, &pos, &changed) || changed > ALL_FIELDS)
+        {
+            return false;
+        }
+        for (size_t i = 0; i < kFieldCount; i++)
+        {
+            if (!(changed & (FieldMask(1) << i)))
+            {
+                continue;
+            }
+            uint64_t len;
+            if (!Varint::get(in, &pos, &len) || len > in.size() - pos)
+            {
+                return false;
+            }
+            rev->fields[i].assign(in.substr(pos, len));
+            pos += len;
+        }
+        return pos == in.size();
+    }
+
+    // 读取正整数参数, 缺省时为 *value 原值, 不合法时已返回错误
+    static bool versionArg(xchain::Context *ctx, const std::string &name, uint64_t *value)
+    {
+        const std::string &arg = ctx->arg(name);
+        if (arg.empty())
+        {
+            return true;
+        }
+        uint64_t v = 0;
+        for (char c : arg)
+        {
+            if (c < '0' || c > '9' || v > (UINT64_MAX - 9) / 10)
+            {
+                v = 0;
+                break;
+            }
+            v = v * 10 + static_cast<uint64_t>(c - '0');
+        }
+        if (v == 0)
+        {
+            ctx->error("invalid '" + name + "'");
+            return false;
+        }
+        *value = v;
+        return true;
+    }
+
+    static std::string toHex(std::string_view bytes)
+    {
+        static const char kHex[] = "0123456789abcdef";
+        std::string hex;
+        hex.reserve(bytes.size() * 2);
+        for (unsigned char c : bytes)
+        {
+            hex += kHex[c >> 4];
+            hex += kHex[c & 0xf];
+        }
+        return hex;
+    }
+
+    // 记录写入后发出 "change" 事件, 订阅方据此得知变更而无需轮询查询方法:
+    // {"agency":"business","userid":"..","version":n,"seq":n,"digest":"<内容摘要的十六进制>"}
+    // seq 为变更日志中的序号, 订阅中断后可从该序号起用 changesSince 补齐; 内容未变而跳过的写入不发事件
+    void emitChange(xchain::Context *ctx, std::string_view userid, uint64_t version, uint64_t seq,
+                    const std::string &digest)
+    {
+        std::string hex = toHex(digest);
+        JsonWriter json(64 + Schema::kAgency.size() + userid.size() + hex.size());
+        json.beginObject();
+        json.field("agency", Schema::kAgency);
+        json.field(USERID, userid);
+        json.key("version");
+        json.number(version);
+        json.key("seq");
+        json.number(seq);
+        json.field("digest", hex);
+        json.endObject();
+        ctx->emit_event("change", json.finish());
+    }
+
+public:
+    void addRecord(std::string_view method)
+    {
+        CallMeter meter(&_ctx, std::string(method));
+        // 获取合约上下文对象
+        xchain::Context *ctx = this->context();
+        if (!checkWriter(ctx))
+        {
+            return;
+        }
+
+        // 从参数中获取主键和全部字段，均为必填参数，缺少则返回错误
+        std::string_view userid;
+        Values values;
+        std::string_view missing = bindArgs(ctx, &userid, &values);
+        if (!missing.empty())
+        {
+            ctx->error(std::string("missing '").append(missing).append("'"));
+            return;
+        }
+
+        WriteStatus status = writeRecord(ctx, userid, values);
+        if (status == WRITE_FAILED)
+        {
+            ctx->error("failed to save score record");
+            return;
+        }
+
+        // 执行成功，返回status code 200; 内容与账本中相同时返回 unchanged
+        ctx->ok(status == WRITE_UNCHANGED ? std::string("unchanged") : std::string(userid));
+    }
+
+    // 部分更新: 参数为userid和要修改的字段, 未给出的字段保持原值
+    // 只重写这一条记录, 索引项仅在对应字段变化时更新
+    // 返回 {"userid":"..","version":n}, 修改后内容不变时不写入, 返回原版本号并附加 "unchanged":true
+    void updateRecord(std::string_view method)
+    {
+        CallMeter meter(&_ctx, std::string(method));
+        // 获取合约上下文对象
+        xchain::Context *ctx = this->context();
+        if (!checkWriter(ctx))
+        {
+            return;
+        }
+
+        const std::string &userid = ctx->arg("userid");
+        if (userid.empty())
+        {
+            ctx->error("missing 'userid'");
+            return;
+        }
+
+        // 读出旧记录, 只能修改已存在的记录
+        StoredRecord old;
+        bool corrupted;
+        if (!loadRecord(ctx, recordKey(userid), &old, &corrupted))
+        {
+            if (corrupted)
+            {
+                ctx->error("corrupted record of " + userid);
+                return;
+            }
+            ctx->error(std::string("no ").append(Schema::kFields[0].name).append(" record found of ") + userid);
+            return;
+        }
+        if (!old.decoded.hasValues)
+        {
+            ctx->error("corrupted record of " + userid);
+            return;
+        }
+
+        // 用参数中给出的字段覆盖旧值, 字段不允许置空
+        Values values = old.decoded.values;
+        size_t changed = 0;
+        for (const auto &kv : ctx->args())
+        {
+            size_t i = fieldIndex(kv.first);
+            if (i == kFieldCount)
+            {
+                continue;
+            }
+            if (kv.second.empty())
+            {
+                ctx->error("empty '" + kv.first + "'");
+                return;
+            }
+            values[i] = kv.second;
+            changed++;
+        }
+        if (changed == 0)
+        {
+            ctx->error("no field to update");
+            return;
+        }
+        // 旧版json记录可能缺少字段, 补齐之前不能写回
+        std::string_view missing = missingField(userid, values);
+        if (!missing.empty())
+        {
+            ctx->error(std::string("missing '").append(missing).append("'"));
+            return;
+        }
+
+        // 旧记录已在手, 直接比较字段值, 不必再读摘要
+        bool same = values == old.decoded.values && old.decoded.legacyJson.empty();
+        uint64_t version = old.decoded.version;
+        if (!same)
+        {
+            std::string fields = Codec::encodeFields(values);
+            if (putRecord(ctx, userid, values, fields, contentDigest(fields), &old, &version) == WRITE_FAILED)
+            {
+                ctx->error("failed to save score record");
+                return;
+            }
+        }
+
+        JsonWriter json(JsonWriter::kObjectOverhead + JsonWriter::fieldSize(USERID, userid) + 48);
+        json.beginObject();
+        json.field(USERID, userid);
+        json.key("version");
+        json.number(version);
+        if (same)
+        {
+            json.key("unchanged");
+            json.boolean(true);
+        }
+        json.endObject();
+        // 执行成功，返回status code 200
+        ctx->ok(json.finish());
+    }
+
+    // 批量写入: 参数 records 为记录对象组成的json数组
+    // 只校验一次owner, 先解析校验全部记录再逐条写入, 某条记录不合法不影响其余记录
+    // 返回每条记录的结果: {"results":[{"index":0,"userid":"..","status":"ok"},...],"succeeded":n,"unchanged":k,"failed":m}
+    // 内容未变的记录 status 为 "unchanged", 同时计入 succeeded
+    void addRecordBatch(std::string_view method)
+    {
+        CallMeter meter(&_ctx, std::string(method));
+        // 获取合约上下文对象
+        xchain::Context *ctx = this->context();
+        if (!checkWriter(ctx))
+        {
+            return;
+        }
+
+        const std::string &records = ctx->arg("records");
+        if (records.empty())
+        {
+            ctx->error("missing 'records'");
+            return;
+        }
+
+        // deque 追加元素时不移动已有元素, 保证字段视图指向的 buf 地址不变
+        std::deque<PendingRecord> pending;
+        JsonReader in(records);
+        if (!in.beginArray())
+        {
+            ctx->error("'records' must be a json array");
+            return;
+        }
+        while (in.next())
+        {
+            if (pending.size() == MAX_BATCH_SIZE)
+            {
+                ctx->error("too many records, at most " + std::to_string(MAX_BATCH_SIZE) + " per batch");
+                return;
+            }
+            pending.emplace_back();
+            if (!bindObject(&in, &pending.back()))
+            {
+                ctx->error("malformed record at index " + std::to_string(pending.size() - 1));
+                return;
+            }
+        }
+        if (!in.finish())
+        {
+            ctx->error("'records' must be a json array");
+            return;
+        }
+
+        size_t succeeded = 0;
+        size_t unchanged = 0;
+        JsonWriter json(64 + pending.size() * 64);
+        json.beginObject();
+        json.key("results");
+        json.beginArray();
+        for (size_t i = 0; i < pending.size(); i++)
+        {
+            const PendingRecord &rec = pending[i];
+            json.beginObject();
+            json.key("index");
+            json.number(i);
+            json.field(USERID, rec.userid);
+            std::string_view missing = missingField(rec.userid, rec.values);
+            if (!missing.empty())
+            {
+                json.field("status", "error");
+                json.field("message", std::string("missing '").append(missing).append("'"));
+            }
+            else
+            {
+                WriteStatus status = writeRecord(ctx, rec.userid, rec.values);
+                if (status == WRITE_FAILED)
+                {
+                    json.field("status", "error");
+                    json.field("message", "failed to save score record");
+                }
+                else
+                {
+                    json.field("status", status == WRITE_UNCHANGED ? "unchanged" : "ok");
+                    succeeded++;
+                    unchanged += status == WRITE_UNCHANGED;
+                }
+            }
+            json.endObject();
+        }
+        json.endArray();
+        json.key("succeeded");
+        json.number(succeeded);
+        json.key("unchanged");
+        json.number(unchanged);
+        json.key("failed");
+        json.number(pending.size() - succeeded);
+        json.endObject();
+
+        // 执行成功，返回status code 200
+        ctx->ok(json.finish());
+    }
+
+    void queryRecord(std::string_view method)
+    {
+        CallMeter meter(&_ctx, std::string(method));
+        // 获取合约上下文对象
+        xchain::Context *ctx = this->context();
+        // 从参数中获取用户主键id，必填参数，没有则返回错误
+        const std::string &userid = ctx->arg("userid");
+        if (userid.empty())
+        {
+            ctx->error("missing 'userid'");
+            return;
+        }
+        FieldMask mask;
+        if (!projection(ctx, &mask))
+        {
+            return;
+        }
+
+        // 从账本中读取记录
+        StoredRecord rec;
+        bool corrupted;
+        if (!loadRecord(ctx, recordKey(userid), &rec, &corrupted))
+        {
+            if (corrupted)
+            {
+                ctx->error("corrupted record of " + userid);
+                return;
+            }
+            // 没查到，说明之前没上链过，返回错误
+            ctx->error(std::string("no ").append(Schema::kFields[0].name).append(" record found of ") + userid);
+            return;
+        }
+
+        JsonWriter json(jsonSize(userid, rec, mask));
+        writeJson(&json, userid, rec, mask);
+        ctx->ok(json.finish());
+    }
+
+    // 供合并部署的合约跨部门组合查询: 读出一条记录的全部字段, 不存在或损坏时返回false
+    // 读出的 Record 在输出前须保持有效, 由 recordJsonSize/writeRecordJson 输出
+    using Record = StoredRecord;
+
+    bool fetchRecord(std::string_view userid, Record *rec)
+    {
+        bool corrupted;
+        return loadRecord(this->context(), recordKey(userid), rec, &corrupted);
+    }
+
+    static size_t recordJsonSize(std::string_view userid, const Record &rec)
+    {
+        return jsonSize(userid, rec, ALL_FIELDS);
+    }
+
+    static void writeRecordJson(JsonWriter *json, std::string_view userid, const Record &rec)
+    {
+        writeJson(json, userid, rec, ALL_FIELDS);
+    }
+
+    // 批量查询: 参数 userids 为主键组成的json数组
+    // 返回 {"records":[记录,...],"missing":[未找到的userid,...]}, 先读出全部记录再一次性写入响应缓冲区
+    void queryRecordBatch(std::string_view method)
+    {
+        CallMeter meter(&_ctx, std::string(method));
+        // 获取合约上下文对象
+        xchain::Context *ctx = this->context();
+        const std::string &userids = ctx->arg("userids");
+        if (userids.empty())
+        {
+            ctx->error("missing 'userids'");
+            return;
+        }
+        FieldMask mask;
+        if (!projection(ctx, &mask))
+        {
+            return;
+        }
+
+        // deque 追加元素时不移动已有元素, 解码结果中的视图保持有效
+        std::deque<StoredRecord> found;
+        std::deque<std::string> idBuf;
+        std::vector<std::string_view> foundIds;
+        std::vector<std::string_view> missing;
+        std::string key;
+        size_t size = 32;
+        JsonReader in(userids);
+        if (!in.beginArray())
+        {
+            ctx->error("'userids' must be a json array");
+            return;
+        }
+        while (in.next())
+        {
+            if (found.size() + missing.size() == MAX_BATCH_SIZE)
+            {
+                ctx->error("too many userids, at most " + std::to_string(MAX_BATCH_SIZE) + " per batch");
+                return;
+            }
+            std::string_view userid;
+            idBuf.emplace_back();
+            if (!in.scalar(&userid, &idBuf.back()) || userid.empty())
+            {
+                ctx->error("malformed userid at index " + std::to_string(found.size() + missing.size()));
+                return;
+            }
+            // 复用同一个键缓冲区
+            key.assign(RECORD_KEY).append(userid);
+            found.emplace_back();
+            bool corrupted;
+            if (loadRecord(ctx, key, &found.back(), &corrupted))
+            {
+                size += jsonSize(userid, found.back(), mask) + 1;
+                foundIds.push_back(userid);
+            }
+            else
+            {
+                // 损坏的记录与不存在的记录一样列入 missing
+                found.pop_back();
+                size += userid.size() + 3;
+                missing.push_back(userid);
+            }
+        }
+        if (!in.finish())
+        {
+            ctx->error("'userids' must be a json array");
+            return;
+        }
+
+        JsonWriter json(size);
+        json.beginObject();
+        json.key("records");
+        json.beginArray();
+        for (size_t i = 0; i < found.size(); i++)
+        {
+            writeJson(&json, foundIds[i], found[i], mask);
+        }
+        json.endArray();
+        json.key("missing");
+        json.beginArray();
+        for (std::string_view userid : missing)
+        {
+            json.string(userid);
+        }
+        json.endArray();
+        json.endObject();
+
+        // 执行成功，返回status code 200
+        ctx->ok(json.finish());
+    }
+
+    // 按带 FIELD_INDEXED 的字段精确查询, 参数名即字段名
+    // 返回 {"records":[...]}, 超过 MAX_INDEX_RESULTS 条时只返回前面部分并附加 "truncated":true
+    // 升级前写入的记录在 reindexRecords 完成前可能没有索引项, 附加 "partial":true
+    void queryRecordBy(std::string_view method, std::string_view field)
+    {
+        CallMeter meter(&_ctx, std::string(method));
+        // 获取合约上下文对象
+        xchain::Context *ctx = this->context();
+        size_t index = fieldIndex(field);
+        if (index == kFieldCount || !(Schema::kFields[index].flags & FIELD_INDEXED))
+        {
+            ctx->error(std::string("field '").append(field).append("' is not indexed"));
+            return;
+        }
+        const std::string &value = ctx->arg(std::string(field));
+        if (value.empty())
+        {
+            ctx->error(std::string("missing '").append(field).append("'"));
+            return;
+        }
+        FieldMask mask;
+        if (!projection(ctx, &mask))
+        {
+            return;
+        }
+
+        std::string start = indexPrefix(index, value);
+        std::string limit = start;
+        limit.back() = '\1';
+        std::deque<StoredRecord> found;
+        std::deque<std::string> foundIds;
+        size_t size = 32;
+        bool truncated = false;
+        auto it = ctx->new_iterator(start, limit);
+        while (it->next())
+        {
+            if (found.size() == MAX_INDEX_RESULTS)
+            {
+                truncated = true;
+                break;
+            }
+            xchain::ElemType elem;
+            if (!it->get(&elem))
+            {
+                break;
+            }
+            found.emplace_back();
+            bool corrupted;
+            // 索引项只是线索, 以记录本身的字段值为准
+            if (!loadRecord(ctx, recordKey(elem.value), &found.back(), &corrupted) ||
+                !found.back().decoded.hasValues || found.back().decoded.values[index] != value)
+            {
+                found.pop_back();
+                continue;
+            }
+            foundIds.push_back(std::move(elem.value));
+            size += jsonSize(foundIds.back(), found.back(), mask) + 1;
+        }
+
+        JsonWriter json(size);
+        json.beginObject();
+        json.key("records");
+        json.beginArray();
+        for (size_t i = 0; i < found.size(); i++)
+        {
+            writeJson(&json, foundIds[i], found[i], mask);
+        }
+        json.endArray();
+        if (truncated)
+        {
+            json.key("truncated");
+            json.boolean(true);
+        }
+        if (!derivedReady(ctx))
+        {
+            json.key("partial");
+            json.boolean(true);
+        }
+        json.endObject();
+
+        // 执行成功，返回status code 200
+        ctx->ok(json.finish());
+    }
+
+    // 按userid顺序分页列举全部记录
+    // 参数: limit - 每页条数, cursor - 上一页返回的游标, keysOnly - 为true时只返回userid
+    // 返回 {"records":[...]} 或 {"userids":[...]}, 还有下一页时附带 "cursor"
+    void listRecords(std::string_view method)
+    {
+        CallMeter meter(&_ctx, std::string(method));
+        // 获取合约上下文对象
+        xchain::Context *ctx = this->context();
+        size_t limit;
+        if (!pageLimit(ctx, &limit))
+        {
+            return;
+        }
+        bool keysOnly = flagArg(ctx, "keysOnly");
+        FieldMask mask;
+        if (!projection(ctx, &mask))
+        {
+            return;
+        }
+
+        // 从游标之后开始扫描 R_ 前缀
+        std::string start = RECORD_KEY;
+        const std::string &cursor = ctx->arg("cursor");
+        if (!cursor.empty())
+        {
+            std::string after;
+            if (!Cursor::decode(cursor, &after))
+            {
+                ctx->error("invalid 'cursor'");
+                return;
+            }
+            start.append(after).append(1, '\0');
+        }
+        std::string end = RECORD_KEY;
+        end.back()++;
+
+        std::deque<StoredRecord> found;
+        std::vector<std::string> userids;
+        size_t size = 64;
+        bool more = false;
+        auto it = ctx->new_iterator(start, end);
+        while (it->next())
+        {
+            if (userids.size() == limit)
+            {
+                more = true;
+                break;
+            }
+            xchain::ElemType elem;
+            if (!it->get(&elem))
+            {
+                break;
+            }
+            userids.push_back(elem.key.substr(RECORD_KEY.size()));
+            if (keysOnly)
+            {
+                size += userids.back().size() + 3;
+                continue;
+            }
+            found.emplace_back();
+            StoredRecord &rec = found.back();
+            rec.data = std::move(elem.value);
+            if (!decodeRecord(ctx, &rec))
+            {
+                // 损坏的记录不输出, 但仍计入本页, 保证游标前进
+                rec.decoded.legacyJson = std::string_view();
+                rec.decoded.hasValues = false;
+            }
+            size += jsonSize(userids.back(), rec, mask) + 1;
+        }
+
+        JsonWriter json(size);
+        json.beginObject();
+        json.key(keysOnly ? "userids" : "records");
+        json.beginArray();
+        for (size_t i = 0; i < userids.size(); i++)
+        {
+            if (keysOnly)
+            {
+                json.string(userids[i]);
+            }
+            else if (found[i].decoded.hasValues || !found[i].decoded.legacyJson.empty())
+            {
+                writeJson(&json, userids[i], found[i], mask);
+            }
+        }
+        json.endArray();
+        if (more)
+        {
+            json.field("cursor", Cursor::encode(userids.back()));
+        }
+        json.endObject();
+
+        // 执行成功，返回status code 200
+        ctx->ok(json.finish());
+    }
+
+    // 增量同步: 按序号顺序返回 seq 之后的变更, 只扫描变更日志而不读记录
+    // 参数: seq - 上次同步到的序号(缺省为0, 即从头开始), limit - 每页条数
+    // 返回 {"changes":[{"seq":n,"userid":"..","version":v},...],"seq":本页最后的序号}, 还有后续时附加 "more":true
+    // 同一userid多次写入时每次都有一项, 调用方按 version 取最新
+    void changesSince(std::string_view method)
+    {
+        CallMeter meter(&_ctx, std::string(method));
+        xchain::Context *ctx = this->context();
+        size_t limit;
+        if (!pageLimit(ctx, &limit))
+        {
+            return;
+        }
+        uint64_t after = 0;
+        for (char c : ctx->arg("seq"))
+        {
+            if (c < '0' || c > '9' || after > (UINT64_MAX - 9) / 10)
+            {
+                ctx->error("invalid 'seq'");
+                return;
+            }
+            after = after * 10 + static_cast<uint64_t>(c - '0');
+        }
+        if (after == UINT64_MAX)
+        {
+            ctx->error("invalid 'seq'");
+            return;
+        }
+
+        std::string end = LOG_KEY;
+        end.back()++;
+        auto it = ctx->new_iterator(logKey(after + 1), end);
+        JsonWriter json(64 + limit * 64);
+        json.beginObject();
+        json.key("changes");
+        json.beginArray();
+        size_t count = 0;
+        uint64_t last = after;
+        bool more = false;
+        xchain::ElemType elem;
+        while (it->next())
+        {
+            if (count == limit)
+            {
+                more = true;
+                break;
+            }
+            uint64_t seq;
+            uint64_t version;
+            size_t pos = 0;
+            if (!it->get(&elem) || !Fixed64::get(std::string_view(elem.key).substr(LOG_KEY.size()), &seq) ||
+                !Varint::get(elem.value, &pos, &version))
+            {
+                ctx->error("corrupted change log");
+                return;
+            }
+            json.beginObject();
+            json.key("seq");
+            json.number(seq);
+            json.field(USERID, std::string_view(elem.value).substr(pos));
+            json.key("version");
+            json.number(version);
+            json.endObject();
+            count++;
+            last = seq;
+        }
+        json.endArray();
+        json.key("seq");
+        json.number(last);
+        if (more)
+        {
+            json.key("more");
+            json.boolean(true);
+        }
+        json.endObject();
+        ctx->ok(json.finish());
+    }
+
+    // 记录的 Merkle 包含证明, 读取 O(log n) 个节点
+    // 返回 {"userid":"..","index":i,"leaves":n,"leaf":"..","root":"..","siblings":[..]}, 哈希均为十六进制
+    // 验证: h = sha256(0x00 || 查询该记录返回的json), 自下而上对第k个兄弟 s, 若 index 第k位为1
+    //       h = sha256(0x01 || s || h), 否则 h = sha256(0x01 || h || s), 最终 h 应等于 root
+    void proveRecord(std::string_view method)
+    {
+        CallMeter meter(&_ctx, std::string(method));
+        xchain::Context *ctx = this->context();
+        const std::string &userid = ctx->arg("userid");
+        if (userid.empty())
+        {
+            ctx->error("missing 'userid'");
+            return;
+        }
+        MerkleTree::Proof proof;
+        if (!_merkle.prove(ctx, userid, &proof))
+        {
+            // 本功能上线前写入且之后未再修改的记录不在树中
+            ctx->error("no merkle proof of " + userid);
+            return;
+        }
+        JsonWriter json(128 + userid.size() + (proof.siblings.size() + 2) * 67);
+        json.beginObject();
+        json.field(USERID, userid);
+        json.key("index");
+        json.number(proof.index);
+        json.key("leaves");
+        json.number(proof.leaves);
+        json.field("leaf", toHex(proof.leaf));
+        json.field("root", toHex(proof.root));
+        json.key("siblings");
+        json.beginArray();
+        for (const std::string &sibling : proof.siblings)
+        {
+            json.string(toHex(sibling));
+        }
+        json.endArray();
+        json.endObject();
+        ctx->ok(json.finish());
+    }
+
+    // 查询记录的某个历史版本, 参数 userid、version, 可用 fields 投影
+    // 返回与 queryRecord 相同格式的json; 读取 R_ 和最多 KEYFRAME_INTERVAL 个修订, 不扫描区块
+    void queryRecordAt(std::string_view method)
+    {
+        CallMeter meter(&_ctx, std::string(method));
+        xchain::Context *ctx = this->context();
+        const std::string &userid = ctx->arg("userid");
+        if (userid.empty())
+        {
+            ctx->error("missing 'userid'");
+            return;
+        }
+        uint64_t version = 0;
+        if (!versionArg(ctx, "version", &version))
+        {
+            return;
+        }
+        if (version == 0)
+        {
+            ctx->error("missing 'version'");
+            return;
+        }
+        FieldMask mask;
+        if (!projection(ctx, &mask))
+        {
+            return;
+        }
+
+        StoredRecord rec;
+        bool corrupted;
+        if (!loadRecord(ctx, recordKey(userid), &rec, &corrupted))
+        {
+            ctx->error(corrupted ? "corrupted record of " + userid
+                                 : std::string("no ").append(Schema::kFields[0].name).append(" record found of ") +
+                                       userid);
+            return;
+        }
+        if (version == rec.decoded.version)
+        {
+            JsonWriter json(jsonSize(userid, rec, mask));
+            writeJson(&json, userid, rec, mask);
+            ctx->ok(json.finish());
+            return;
+        }
+        if (version > rec.decoded.version)
+        {
+            ctx->error("no version " + std::to_string(version) + " of " + userid);
+            return;
+        }
+
+        bool found = false;
+        std::string out;
+        bool ok = replayRevisions(ctx, userid, version, version, [&](const Revision &rev) {
+            Values values = rev.values();
+            JsonWriter json(jsonSize(userid, values, mask));
+            writeJson(&json, userid, values, mask);
+            out = json.finish();
+            found = true;
+        });
+        if (!ok)
+        {
+            ctx->error("corrupted history of " + userid);
+            return;
+        }
+        if (!found)
+        {
+            // 升级前只保留了最后一个版本
+            ctx->error("version " + std::to_string(version) + " of " + userid + " is not retained");
+            return;
+        }
+        ctx->ok(out);
+    }
+
+    // 记录的修订历史, 从新到旧排列, 参数: userid, limit - 条数, before - 只返回小于该版本号的修订
+    // 返回 {"userid":"..","revisions":[{"version":v,"seq":s,"record":{..}},...]}, 还有更早的修订时附加 "more":true
+    // seq 为该次写入在变更日志中的序号, 升级前的版本为0; 读取的修订数不超过 limit + KEYFRAME_INTERVAL - 1
+    void recordHistory(std::string_view method)
+    {
+        CallMeter meter(&_ctx, std::string(method));
+        xchain::Context *ctx = this->context();
+        const std::string &userid = ctx->arg("userid");
+        if (userid.empty())
+        {
+            ctx->error("missing 'userid'");
+            return;
+        }
+        size_t limit;
+        if (!pageLimit(ctx, &limit))
+        {
+            return;
+        }
+        uint64_t before = UINT64_MAX;
+        if (!versionArg(ctx, "before", &before))
+        {
+            return;
+        }
+
+        // 只需记录头中的版本号, 不查字典
+        std::string data;
+        typename Codec::Decoded current;
+        if (!ctx->get_object(recordKey(userid), &data))
+        {
+            ctx->error(std::string("no ").append(Schema::kFields[0].name).append(" record found of ") + userid);
+            return;
+        }
+        if (!Codec::decode(data, &current))
+        {
+            ctx->error("corrupted record of " + userid);
+            return;
+        }
+
+        uint64_t top = std::min(current.version, before - 1);
+        uint64_t bottom = top > limit ? top - limit + 1 : 1;
+        std::vector<std::string> revisions;
+        uint64_t oldest = 0;
+        bool ok = top == 0 || replayRevisions(ctx, userid, bottom, top, [&](const Revision &rev) {
+            Values values = rev.values();
+            JsonWriter json(64 + jsonSize(userid, values));
+            json.beginObject();
+            json.key("version");
+            json.number(rev.version);
+            json.key("seq");
+            json.number(rev.seq);
+            json.key("record");
+            writeJson(&json, userid, values);
+            json.endObject();
+            revisions.push_back(json.finish());
+            if (oldest == 0)
+            {
+                oldest = rev.version;
+            }
+        });
+        if (!ok)
+        {
+            ctx->error("corrupted history of " + userid);
+            return;
+        }
+
+        size_t size = 64 + userid.size();
+        for (const std::string &r : revisions)
+        {
+            size += r.size() + 1;
+        }
+        JsonWriter json(size);
+        json.beginObject();
+        json.field(USERID, userid);
+        json.key("revisions");
+        json.beginArray();
+        for (auto r = revisions.rbegin(); r != revisions.rend(); ++r)
+        {
+            json.raw(*r);
+        }
+        json.endArray();
+        // 本页最早的版本之前还有版本; 中间有未保留的版本时后面的都已无法重建
+        if (oldest == bottom && bottom > 1)
+        {
+            json.key("more");
+            json.boolean(true);
+        }
+        json.endObject();
+        ctx->ok(json.finish());
+    }
+
+    // 列出到期日在 [from, to] 内的记录, 按到期日排列; 参数 from/to 为 YYYY-MM-DD, limit、cursor 分页
+    // 返回 {"expiring":[{"userid":"..","expiry":"YYYY-MM-DD"},...]}, 还有下一页时附带 "cursor"
+    // 只扫描区间内的索引项, 不读记录; 升级前写入的记录在 reindexRecords 完成前未计入, 附加 "partial":true
+    void expiringBetween(std::string_view method)
+    {
+        CallMeter meter(&_ctx, std::string(method));
+        xchain::Context *ctx = this->context();
+        if constexpr (flaggedField(FIELD_EXPIRY) == kFieldCount)
+        {
+            ctx->error("no expiry field");
+            return;
+        }
+        int64_t from;
+        int64_t to;
+        if (!FieldFormat::parseDate(ctx->arg("from"), &from) || !FieldFormat::parseDate(ctx->arg("to"), &to))
+        {
+            ctx->error("'from' and 'to' must be dates in YYYY-MM-DD");
+            return;
+        }
+        size_t limit;
+        if (!pageLimit(ctx, &limit))
+        {
+            return;
+        }
+        std::string start = expiryKey(from, "");
+        std::string end = expiryKey(to + 1, "");
+        const std::string &cursor = ctx->arg("cursor");
+        if (!cursor.empty())
+        {
+            std::string after;
+            if (!Cursor::decode(cursor, &after))
+            {
+                ctx->error("invalid 'cursor'");
+                return;
+            }
+            start = std::max(start, std::string(EXPIRY_KEY).append(after).append(1, '\0'));
+        }
+
+        JsonWriter json(96 + limit * 64);
+        json.beginObject();
+        json.key("expiring");
+        json.beginArray();
+        size_t count = 0;
+        std::string last;
+        std::string date;
+        bool more = false;
+        auto it = ctx->new_iterator(start, end);
+        xchain::ElemType elem;
+        while (it->next())
+        {
+            if (count == limit)
+            {
+                more = true;
+                break;
+            }
+            uint64_t days;
+            if (!it->get(&elem) || elem.key.size() <= EXPIRY_KEY.size() + Fixed64::kSize ||
+                !Fixed64::get(std::string_view(elem.key).substr(EXPIRY_KEY.size(), Fixed64::kSize), &days))
+            {
+                ctx->error("corrupted expiry index");
+                return;
+            }
+            FieldFormat::formatDate(&date, static_cast<int64_t>(days ^ (uint64_t(1) << 63)));
+            json.beginObject();
+            json.field(USERID, std::string_view(elem.key).substr(EXPIRY_KEY.size() + Fixed64::kSize));
+            json.field("expiry", date);
+            json.endObject();
+            last = elem.key.substr(EXPIRY_KEY.size());
+            count++;
+        }
+        json.endArray();
+        if (more)
+        {
+            json.field("cursor", Cursor::encode(last));
+        }
+        if (!derivedReady(ctx))
+        {
+            json.key("partial");
+            json.boolean(true);
+        }
+        json.endObject();
+        ctx->ok(json.finish());
+    }
+
+    // 列出地址位于某一行政区划内的记录, 按区划路径排列; 参数 code 为区划路径, limit、cursor 分页
+    // code 可写作 "北京市/海淀区" 或 "北京市海淀区", 须从地址写出的第一级开始, 可到任一级为止
+    // 返回 {"records":[{"userid":"..","region":"北京市/海淀区/西北旺镇"},...]}, 还有下一页时附带 "cursor"
+    // 只做一次前缀扫描, 不读记录; 升级前写入的记录在 reindexRecords 完成前未计入, 附加 "partial":true
+    void listByRegion(std::string_view method)
+    {
+        CallMeter meter(&_ctx, std::string(method));
+        xchain::Context *ctx = this->context();
+        if constexpr (flaggedField(FIELD_REGION) == kFieldCount)
+        {
+            ctx->error("no region field");
+            return;
+        }
+        std::string code;
+        for (char c : ctx->arg("code"))
+        {
+            if (c != '/')
+            {
+                code += c;
+            }
+        }
+        RegionPath levels;
+        size_t count = regionLevels(code, &levels);
+        if (count == 0 || levels[count - 1].data() + levels[count - 1].size() != code.data() + code.size())
+        {
+            ctx->error("'code' must be a region path such as 北京市/海淀区");
+            return;
+        }
+        size_t limit;
+        if (!pageLimit(ctx, &limit))
+        {
+            return;
+        }
+        std::string start = regionPrefix(levels, count);
+        std::string end = start;
+        end.back()++;
+        const std::string &cursor = ctx->arg("cursor");
+        if (!cursor.empty())
+        {
+            std::string after;
+            if (!Cursor::decode(cursor, &after))
+            {
+                ctx->error("invalid 'cursor'");
+                return;
+            }
+            start = std::max(start, std::string(REGION_KEY).append(after).append(1, '\0'));
+        }
+
+        JsonWriter json(96 + limit * 96);
+        json.beginObject();
+        json.key("records");
+        json.beginArray();
+        size_t found = 0;
+        std::string last;
+        std::string region;
+        bool more = false;
+        auto it = ctx->new_iterator(start, end);
+        xchain::ElemType elem;
+        while (it->next())
+        {
+            if (found == limit)
+            {
+                more = true;
+                break;
+            }
+            size_t sep;
+            if (!it->get(&elem) || (sep = elem.key.find('\0', REGION_KEY.size())) == std::string::npos)
+            {
+                ctx->error("corrupted region index");
+                return;
+            }
+            // 各级之间的 \x01 换成 /, 去掉末尾的一个
+            region.assign(elem.key, REGION_KEY.size(), sep - REGION_KEY.size() - 1);
+            std::replace(region.begin(), region.end(), '\x01', '/');
+            json.beginObject();
+            json.field(USERID, std::string_view(elem.key).substr(sep + 1));
+            json.field("region", region);
+            json.endObject();
+            last = elem.key.substr(REGION_KEY.size());
+            found++;
+        }
+        json.endArray();
+        if (more)
+        {
+            json.field("cursor", Cursor::encode(last));
+        }
+        if (!derivedReady(ctx))
+        {
+            json.key("partial");
+            json.boolean(true);
+        }
+        json.endObject();
+        ctx->ok(json.finish());
+    }
+
+    // 按关键词检索 FIELD_SEARCHED 字段, 参数 keywords 为以空白或标点分隔的若干关键词, 每个至少两个字, limit、cursor 分页
+    // 记录须在任一检索字段中包含每个关键词(不区分ASCII大小写); 先求各关键词二元组倒排表的交集, 再读记录核对原文
+    // 返回 {"records":[{检索字段..,"userid":".."},...]}, 按userid排列; 核对过的候选达到 limit 的4倍时也提前结束
+    // 提前结束时附带 "cursor", 下一页可能为空; 升级前写入的记录在 reindexRecords 完成前未计入, 附加 "partial":true
+    void searchRecords(std::string_view method)
+    {
+        CallMeter meter(&_ctx, std::string(method));
+        xchain::Context *ctx = this->context();
+        if constexpr (!hasFieldFlag(FIELD_SEARCHED))
+        {
+            ctx->error("no searchable field");
+            return;
+        }
+        // 关键词按与索引相同的方式规范化后, 在标点和空白处切开
+        std::string normalized = NgramIndex::normalize(ctx->arg("keywords"));
+        std::vector<std::string_view> keywords;
+        std::vector<std::string> terms;
+        for (size_t pos = 0; pos < normalized.size();)
+        {
+            size_t end = normalized.find('\0', pos);
+            end = end == std::string::npos ? normalized.size() : end;
+            if (end > pos)
+            {
+                std::string_view keyword = std::string_view(normalized).substr(pos, end - pos);
+                std::vector<std::string> t = NgramIndex::terms({keyword});
+                if (t.empty())
+                {
+                    ctx->error(std::string("keyword '").append(keyword).append("' is too short"));
+                    return;
+                }
+                keywords.push_back(keyword);
+                terms.insert(terms.end(), t.begin(), t.end());
+            }
+            pos = end + 1;
+        }
+        if (keywords.empty())
+        {
+            ctx->error("missing 'keywords'");
+            return;
+        }
+        std::sort(terms.begin(), terms.end());
+        terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+        size_t limit;
+        if (!pageLimit(ctx, &limit))
+        {
+            return;
+        }
+        std::string after;
+        const std::string &cursor = ctx->arg("cursor");
+        if (!cursor.empty() && !Cursor::decode(cursor, &after))
+        {
+            ctx->error("invalid 'cursor'");
+            return;
+        }
+
+        FieldMask mask = 0;
+        for (size_t i = 0; i < kFieldCount; i++)
+        {
+            if (Schema::kFields[i].flags & FIELD_SEARCHED)
+            {
+                mask |= FieldMask(1) << i;
+            }
+        }
+        JsonWriter json(96 + limit * 256);
+        json.beginObject();
+        json.key("records");
+        json.beginArray();
+        NgramIndex::Intersection hits(ctx, _ngrams, terms, after);
+        std::string userid;
+        size_t found = 0;
+        size_t checked = 0;
+        bool more = false;
+        while (true)
+        {
+            if (found == limit || checked == limit * 4)
+            {
+                more = true;
+                break;
+            }
+            if (!hits.next(&userid))
+            {
+                break;
+            }
+            checked++;
+            StoredRecord rec;
+            bool corrupted;
+            if (!loadRecord(ctx, recordKey(userid), &rec, &corrupted) || !rec.decoded.hasValues)
+            {
+                continue;
+            }
+            bool match = true;
+            for (std::string_view keyword : keywords)
+            {
+                bool contains = false;
+                for (size_t i = 0; i < kFieldCount && !contains; i++)
+                {
+                    contains = (mask & (FieldMask(1) << i)) &&
+                               NgramIndex::normalize(rec.decoded.values[i]).find(keyword) != std::string::npos;
+                }
+                match = match && contains;
+            }
+            if (!match)
+            {
+                continue;
+            }
+            writeJson(&json, userid, rec.decoded.values, mask);
+            found++;
+        }
+        json.endArray();
+        if (more)
+        {
+            json.field("cursor", Cursor::encode(userid));
+        }
+        if (!derivedReady(ctx))
+        {
+            json.key("partial");
+            json.boolean(true);
+        }
+        json.endObject();
+        ctx->ok(json.finish());
+    }
+
+    // 按 FIELD_GROUPED 字段的取值查询汇总, 参数名即字段名, 只读取 AGGREGATE_SHARDS 个分块
+    // 返回 {"<字段名>":"..","count":n,"<求和字段>":"总和",...}
+    // 从旧版本升级且 reindexRecords 尚未完成时, 升级前写入的记录未计入, 附加 "partial":true
+    void queryAggregate(std::string_view method, std::string_view field)
+    {
+        CallMeter meter(&_ctx, std::string(method));
+        xchain::Context *ctx = this->context();
+        size_t index = fieldIndex(field);
+        if (index == kFieldCount || !(Schema::kFields[index].flags & FIELD_GROUPED))
+        {
+            ctx->error(std::string("field '").append(field).append("' is not grouped"));
+            return;
+        }
+        const std::string &value = ctx->arg(std::string(field));
+        if (value.empty())
+        {
+            ctx->error(std::string("missing '").append(field).append("'"));
+            return;
+        }
+
+        int64_t count = 0;
+        Sums sums;
+        sums.fill(0);
+        for (size_t shard = 0; shard < AGGREGATE_SHARDS; shard++)
+        {
+            int64_t shardCount;
+            Sums shardSums;
+            if (!loadAggregate(ctx, aggregateKey(index, value, shard), &shardCount, &shardSums))
+            {
+                ctx->error("corrupted aggregate of " + value);
+                return;
+            }
+            count += shardCount;
+            for (size_t i = 0; i < kFieldCount; i++)
+            {
+                sums[i] += shardSums[i];
+            }
+        }
+
+        JsonWriter json(96 + JsonWriter::fieldSize(field, value) + kFieldCount * 48);
+        json.beginObject();
+        json.field(field, value);
+        json.key("count");
+        json.number(static_cast<uint64_t>(count < 0 ? 0 : count));
+        std::string text;
+        for (size_t i = 0; i < kFieldCount; i++)
+        {
+            if (!(Schema::kFields[i].flags & FIELD_SUMMED))
+            {
+                continue;
+            }
+            // 去掉定点数末尾多余的0
+            FieldFormat::formatDecimal(&text, sums[i], SUM_SCALE);
+            while (text.back() == '0')
+            {
+                text.pop_back();
+            }
+            if (text.back() == '.')
+            {
+                text.pop_back();
+            }
+            json.field(Schema::kFields[i].name, text);
+        }
+        if (!derivedReady(ctx))
+        {
+            json.key("partial");
+            json.boolean(true);
+        }
+        json.endObject();
+        ctx->ok(json.finish());
+    }
+
+    // 查询记录是否存在, 不返回记录内容
+    // 返回 {"userid":"..","exists":true|false}
+    void existsRecord(std::string_view method)
+    {
+        CallMeter meter(&_ctx, std::string(method));
+        xchain::Context *ctx = this->context();
+        const std::string &userid = ctx->arg("userid");
+        if (userid.empty())
+        {
+            ctx->error("missing 'userid'");
+            return;
+        }
+        JsonWriter json(40 + userid.size());
+        json.beginObject();
+        json.field(USERID, userid);
+        json.key("exists");
+        json.boolean(recordExists(ctx, userid));
+        json.endObject();
+        ctx->ok(json.finish());
+    }
+
+    // 批量查询记录是否存在: 参数 userids 为主键组成的json数组
+    // 返回 {"found":[存在的userid,...],"missing":[不存在的userid,...]}
+    void existsRecordBatch(std::string_view method)
+    {
+        CallMeter meter(&_ctx, std::string(method));
+        xchain::Context *ctx = this->context();
+        const std::string &userids = ctx->arg("userids");
+        if (userids.empty())
+        {
+            ctx->error("missing 'userids'");
+            return;
+        }
+        std::deque<std::string> idBuf;
+        std::vector<std::string_view> found;
+        std::vector<std::string_view> missing;
+        size_t size = 32;
+        JsonReader in(userids);
+        if (!in.beginArray())
+        {
+            ctx->error("'userids' must be a json array");
+            return;
+        }
+        while (in.next())
+        {
+            if (found.size() + missing.size() == MAX_BATCH_SIZE)
+            {
+                ctx->error("too many userids, at most " + std::to_string(MAX_BATCH_SIZE) + " per batch");
+                return;
+            }
+            std::string_view userid;
+            idBuf.emplace_back();
+            if (!in.scalar(&userid, &idBuf.back()) || userid.empty())
+            {
+                ctx->error("malformed userid at index " + std::to_string(found.size() + missing.size()));
+                return;
+            }
+            (recordExists(ctx, userid) ? found : missing).push_back(userid);
+            size += userid.size() + 3;
+        }
+        if (!in.finish())
+        {
+            ctx->error("'userids' must be a json array");
+            return;
+        }
+
+        JsonWriter json(size);
+        json.beginObject();
+        json.key("found");
+        json.beginArray();
+        for (std::string_view userid : found)
+        {
+            json.string(userid);
+        }
+        json.endArray();
+        json.key("missing");
+        json.beginArray();
+        for (std::string_view userid : missing)
+        {
+            json.string(userid);
+        }
+        json.endArray();
+        json.endObject();
+        ctx->ok(json.finish());
+    }
+
+    // 为升级前写入的记录补齐 updateDerived 维护的结构以及二级、到期、行政区划和关键词索引, 只有owner可以调用
+    // 参数: limit - 每页条数, cursor - 上一页返回的游标
+    // 返回 {"reindexed":n}, 还有下一页时附带 "cursor"; 最后一页完成后 exists 才启用过滤器
+    void reindexRecords(std::string_view method)
+    {
+        CallMeter meter(&_ctx, std::string(method));
+        xchain::Context *ctx = this->context();
+        if (!checkWriter(ctx))
+        {
+            return;
+        }
+        size_t limit;
+        if (!pageLimit(ctx, &limit))
+        {
+            return;
+        }
+        std::string start = RECORD_KEY;
+        const std::string &cursor = ctx->arg("cursor");
+        if (!cursor.empty())
+        {
+            std::string after;
+            if (!Cursor::decode(cursor, &after))
+            {
+                ctx->error("invalid 'cursor'");
+                return;
+            }
+            start.append(after).append(1, '\0');
+        }
+        std::string end = RECORD_KEY;
+        end.back()++;
+
+        size_t count = 0;
+        std::string last;
+        bool more = false;
+        auto it = ctx->new_iterator(start, end);
+        while (it->next())
+        {
+            if (count == limit)
+            {
+                more = true;
+                break;
+            }
+            xchain::ElemType elem;
+            if (!it->get(&elem))
+            {
+                break;
+            }
+            last = elem.key.substr(RECORD_KEY.size());
+            count++;
+            StoredRecord rec;
+            rec.data = std::move(elem.value);
+            // 无法解析的记录没有字段值, 只计入过滤器
+            bool ok = (decodeRecord(ctx, &rec) && rec.decoded.hasValues)
+                          ? updateDerived(ctx, last, rec.decoded.values) &&
+                                updateIndexes(ctx, last, nullptr, rec.decoded.values) &&
+                                updateExpiry(ctx, last, nullptr, rec.decoded.values) &&
+                                updateRegion(ctx, last, nullptr, rec.decoded.values) &&
+                                updateSearch(ctx, last, nullptr, rec.decoded.values)
+                          : _bloom.add(ctx, last);
+            if (!ok)
+            {
+                ctx->error("failed to reindex record of " + last);
+                return;
+            }
+        }
+        if (!more && !ctx->put_object(READY_KEY, "1"))
+        {
+            ctx->error("failed to reindex records");
+            return;
+        }
+
+        std::string next = more ? Cursor::encode(last) : std::string();
+        JsonWriter json(64 + next.size());
+        json.beginObject();
+        json.key("reindexed");
+        json.number(count);
+        if (more)
+        {
+            json.field("cursor", next);
+        }
+        json.endObject();
+        ctx->ok(json.finish());
+    }
+
+    void queryOwner(std::string_view method)
+    {
+        CallMeter meter(&_ctx, std::string(method));
+        // 获取合约上下文对象
+        xchain::Context *ctx = this->context();
+        std::string owner;
+        if (!ctx->get_object(OWNER_KEY, &owner))
+        {
+            // 没查到owner信息，可能
+            ctx->error("get owner failed");
+            return;
+        }
+        // 执行成功，返回owner address
+        ctx->ok(owner);
+    }
+
+    // 列出本合约全部方法的累计资源消耗, 见 CallMeter
+    void queryCallStats()
+    {
+        CallMeter::queryStats(this->context());
+    }
+
+private:
+    MeteredContext _ctx;
+    // 全部记录的 Merkle 树, 叶子为 sha256(0x00 || 记录的完整json)
+    MerkleTree _merkle;
+    // 出现过的全部userid
+    BloomFilter _bloom;
+    NgramIndex _ngrams;
+    // 本次调用内查过或写入的字典项: 引用 -> 原文
+    std::map<std::string, std::string, std::less<>> _dict;
+    // 本次调用内读出或分配的最新序号
+    uint64_t _sequence = 0;
+    bool _sequenceLoaded = false;
+    // READY_KEY 是否存在, -1 为尚未读取
+    int _ready = -1;
+};
+
+// 单部门合约: 账本键不带命名空间前缀, 与已部署合约中的数据兼容
+template <class Schema>
+class RecordContract : public xchain::Contract, public RecordStore<Schema>
+{
+public:
+    RecordContract() : RecordStore<Schema>(xchain::Contract::context()) {}
+
+    using RecordStore<Schema>::context;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// 记录压缩用的预置字典, 由 tools/train_dict 根据 83 条样本生成, 不要手工修改
+// 已压缩的记录依赖字典内容, 重新训练时须同时递增 RECORD_DICT_ID 并保留旧字典用于解压
+inline constexpr uint8_t RECORD_DICT_ID = 1;
+inline constexpr std::string_view RECORD_DICT =
+    "长期"
+    "通州"
+    "贸易"
+    "货物"
+    "设备"
+    "工程"
+    "华润"
+    "保利"
+    "丰台"
+    "中心"
+    "；餐饮"
+    "科技园"
+    "术转让"
+    "术交流"
+    "广东省"
+    "01室"
+    "；会议服"
+    "街道"
+    "安置房项"
+    "大厦"
+    "商品"
+    "信息"
+    "业管理；"
+    ")第00"
+    "京市海淀区"
+    "号楼"
+    "昌平区回龙观镇"
+    "集团有限责任公司"
+    "管理"
+    "房地产开"
+    "北京市西城区金融"
+    "；销售"
+    "国用(20"
+    "至20"
+    "技术开发、技术咨询、技术"
+    "城镇住宅用地"
+    "北京市朝阳区"
+    "软件开发；计算机系统服务；"
+    "服务；"
+    "用地"
+    "依法须经批准的项目，经相关部门批准后依批准的内容开展经营活动"
+    "有限公司"
+    "北京";
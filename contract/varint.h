@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// LEB128 无符号变长整数: 每字节低7位为数据, 最高位表示后面还有字节
+class Varint
+{
+public:
+    static size_t size(uint64_t v)
+    {
+        size_t n = 1;
+        while (v >= 0x80)
+        {
+            v >>= 7;
+            n++;
+        }
+        return n;
+    }
+
+    static void put(std::string *out, uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            *out += static_cast<char>((v & 0x7f) | 0x80);
+            v >>= 7;
+        }
+        *out += static_cast<char>(v);
+    }
+
+    // 有符号整数映射为无符号, 绝对值小的数编码后也短
+    static uint64_t zigzag(int64_t v)
+    {
+        return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+    }
+
+    static int64_t unzigzag(uint64_t v)
+    {
+        return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+    }
+
+    // 从 in[*pos] 读取一个整数并前移 *pos, 数据不完整时返回false
+    static bool get(std::string_view in, size_t *pos, uint64_t *v)
+    {
+        uint64_t result = 0;
+        for (int shift = 0; shift < 64 && *pos < in.size(); shift += 7)
+        {
+            uint8_t b = static_cast<uint8_t>(in[(*pos)++]);
+            result |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80))
+            {
+                *v = result;
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// 8字节大端无符号整数, 作为账本键的一部分时按字节序即按数值排列
+class Fixed64
+{
+public:
+    static constexpr size_t kSize = 8;
+
+    static void put(std::string *out, uint64_t v)
+    {
+        for (int shift = 56; shift >= 0; shift -= 8)
+        {
+            *out += static_cast<char>((v >> shift) & 0xff);
+        }
+    }
+
+    // in 恰好为 kSize 字节时解出整数
+    static bool get(std::string_view in, uint64_t *v)
+    {
+        if (in.size() != kSize)
+        {
+            return false;
+        }
+        *v = 0;
+        for (char c : in)
+        {
+            *v = (*v << 8) | static_cast<uint8_t>(c);
+        }
+        return true;
+    }
+};
@@ -1,136 +1,7 @@
 #include "xchain/xchain.h"
 
-
-// 学生成绩上链存证API规范
-// 参数由Context提供
-class ScoreRecord {
-public:
-    // 初始化写入权限
-    // 参数: owner - 具有写入权限的address
-    virtual void initialize() = 0;
-
-    // 写入课程成绩
-    // 参数: userid - 学生的主键id
-    //      data - 学生的成绩信息(json格式string)
-    virtual void addScore() = 0;
-
-    // 按照学生id查询成绩
-    // 参数: userid - 学生的主键id
-    // 返回值: data - 学生的成绩信息(json格式string)
-    virtual void queryScore() = 0;
-
-    // 查询具有写权限的账户
-    // 返回值: 具有写权限的address
-    virtual void queryOwner() = 0;
-};
-
-struct ScoreRecordDemo : public ScoreRecord, public xchain::Contract {
-private:
-    // define the key prefix of buckets
-    const std::string OWNER_KEY = "Owner";
-    const std::string RECORD_KEY = "R_";
-
-    // check if caller is the owner of this contract
-    bool isOwner(xchain::Context* ctx, const std::string& caller) {
-        std::string owner;
-        if (!ctx->get_object(OWNER_KEY, &owner)) {
-            return false;
-        }
-        return (owner == caller);
-    }
-
-public:
-    void initialize() {
-        // 获取合约上下文对象
-        xchain::Context* ctx = this->context();
-        // 从合约上下文中获取合约参数, 由合约部署者指定具有写入权限的address
-        std::string owner = ctx->arg("owner");
-        if (owner.empty()) {
-            ctx->error("missing owner address");
-            return;
-        }
-        // 将具有写入权限的owner地址记录在区块链账本中
-        ctx->put_object(OWNER_KEY, owner);
-        ctx->ok("success");
-    }
-
-    void addScore() {
-        // 获取合约上下文对象
-        xchain::Context* ctx = this->context();
-        // 获取发起者身份
-        const std::string& caller = ctx->initiator();
-        if (caller.empty()) {
-            ctx->error("missing initiator");
-            return;
-        }
-        // 如果写操作发起者不是具有写权限的用户，则无权写入
-        if (!isOwner(ctx, caller)) {
-            ctx->error(
-                "permission check failed, only the owner can add score record");
-            return;
-        }
-
-        // 从参数中获取用户主键id，必填参数，没有则返回错误
-        const std::string& userid = ctx->arg("userid");
-        if (userid.empty()) {
-            ctx->error("missing 'userid'");
-            return;
-        }
-        // 从参数中获取成绩数据，必填参数，没有则返回错误
-        const std::string& data = ctx->arg("data");
-        if (data.empty()) {
-            ctx->error("missing 'data'");
-            return;
-        }
-
-        // 将具有写入权限的owner地址记录在区块链账本中
-        std::string score_key = RECORD_KEY + userid;
-        if (!ctx->put_object(score_key, data)) {
-            ctx->error("failed to save score record");
-            return;
-        }
-
-        // 执行成功，返回status code 200
-        ctx->ok(userid);
-    }
-
-    void queryScore() {
-        // 获取合约上下文对象
-        xchain::Context* ctx = this->context();
-
-        // 从参数中获取用户主键id，必填参数，没有则返回错误
-        const std::string& userid = ctx->arg("userid");
-        if (userid.empty()) {
-            ctx->error("missing 'userid'");
-            return;
-        }
-
-        // 从账本中读取学生的成绩数据
-        std::string score_key = RECORD_KEY + userid;
-        std::string data;
-        if (!ctx->get_object(score_key, &data)) {
-            // 没查到，说明之前没上链过，返回错误
-            ctx->error("no score record found of " + userid);
-            return;
-        }
-
-        // 执行成功，返回status code 200
-        ctx->ok(data);
-    }
-
-    void queryOwner() {
-        // 获取合约上下文对象
-        xchain::Context* ctx = this->context();
-        std::string owner;
-        if (!ctx->get_object(OWNER_KEY, &owner)) {
-            // 没查到owner信息，可能
-            ctx->error("get owner failed");
-            return;
-        }
-        // 执行成功，返回owner address
-        ctx->ok(owner);
-    }
-};
+#include "agency_schemas.h"
+#include "record_contract.h"
 
 //公安局
 class Police
@@ -147,207 +18,200 @@ public:
 
     // 按照身份证查询信息
     // 参数: userid - 主键身份证号
+    // 可选参数: fields - 逗号分隔的字段名, 只返回这些字段(userid总是返回)
     // 返回值: data - 公民的身份证信息(json格式string)
     virtual void queryPolice() = 0;
 
     // 查询具有写权限的账户
     // 返回值: 具有写权限的sex
     virtual void PoliceQueryOwner() = 0;
-};
 
-class PoliceData
-{
-public:
-    std::string name;//姓名
-    std::string sex;//性别
-    std::string nation;//民族
-    std::string address;//地址
-    std::string effectiveDate;//有效日期
+    // 批量写入身份证信息
+    // 参数: records - 记录数组(json格式string), 每个元素包含userid及全部字段
+    // 返回值: 每条记录的写入结果(json格式string), 单条不合法不影响其余记录
+    virtual void addPoliceBatch() = 0;
+
+    // 批量查询身份证信息
+    // 参数: userids - 主键数组(json格式string)
+    // 可选参数: fields - 逗号分隔的字段名, 只返回这些字段(userid总是返回)
+    // 返回值: records - 查到的记录数组, missing - 未查到的主键数组(json格式string)
+    virtual void queryPoliceBatch() = 0;
+
+    // 分页列举身份证信息
+    // 参数: limit - 每页条数(默认20, 最大100), cursor - 上一页返回的游标, keysOnly - 为true时只返回主键
+    // 可选参数: fields - 逗号分隔的字段名, 只返回这些字段(userid总是返回)
+    // 返回值: records/userids - 本页数据, cursor - 存在下一页时返回(json格式string)
+    virtual void listPolice() = 0;
+
+    // 部分更新身份证信息, 只需传入要修改的字段
+    // 参数: userid - 主键id（身份证）, 其余为要修改的字段, 未传入的字段保持不变
+    // 返回值: userid及更新后的记录版本号version(json格式string)
+    virtual void updatePolice() = 0;
+
+    // 查询各方法累计的资源消耗, 只累计带了参数 stats=true 并写了账本的调用
+    // 返回值: stats - 每个方法的调用次数calls、账本读写次数reads/writes、读写字节数bytesRead/bytesWritten、遍历步数iteratorSteps(json格式string)
+    virtual void queryStats() = 0;
+
+    // 按序号增量同步身份证信息的变更
+    // 参数: seq - 上次同步到的序号(缺省为0), limit - 每页条数(默认20, 最大100)
+    // 返回值: changes - seq之后按序号排列的变更(seq、userid、version), seq - 本页最后的序号, more - 还有后续时为true(json格式string)
+    virtual void PoliceChangesSince() = 0;
+
+    // 查询身份证信息的 Merkle 包含证明, 第三方可据此单独验证一条记录
+    // 参数: userid - 主键id（身份证）
+    // 返回值: index - 叶子编号, leaves - 叶子总数, leaf/root - 叶子和根哈希, siblings - 自下而上的兄弟节点哈希(json格式string)
+    // 验证: 叶子为 sha256(0x00 || 查询该记录返回的json), 依次与兄弟节点按 sha256(0x01 || 左 || 右) 合并, 结果应等于 root
+    virtual void queryPoliceProof() = 0;
+
+    // 查询身份证信息是否存在, 不读取记录内容
+    // 参数: userid - 主键id（身份证）
+    // 返回值: userid及是否存在exists(json格式string)
+    virtual void existsPolice() = 0;
+
+    // 批量查询身份证信息是否存在
+    // 参数: userids - 主键数组(json格式string)
+    // 返回值: found - 存在的主键数组, missing - 不存在的主键数组(json格式string)
+    virtual void existsPoliceBatch() = 0;
+
+    // 为升级前写入的身份证信息补齐存在性过滤器、Merkle 树、到期索引和区划索引, 需分页调用到没有cursor返回为止
+    // 参数: limit - 每页条数(默认20, 最大100), cursor - 上一页返回的游标
+    // 返回值: reindexed - 本页处理的条数, cursor - 存在下一页时返回(json格式string)
+    virtual void reindexPolice() = 0;
+
+    // 查询身份证信息的某个历史版本
+    // 参数: userid - 主键id（身份证）, version - 版本号, fields - 逗号分隔的字段名(可选, 缺省返回全部字段)
+    // 返回值: 该版本的身份证信息, 格式与查询当前版本相同(json格式string)
+    virtual void queryPoliceAt() = 0;
+
+    // 查询身份证信息的修订历史, 从新到旧排列
+    // 参数: userid - 主键id（身份证）, limit - 条数(默认20, 最大100), before - 只返回小于该版本号的修订(可选)
+    // 返回值: revisions - 各修订的版本号version、变更序号seq和当时的记录record, more - 还有更早的修订时为true(json格式string)
+    virtual void queryPoliceHistory() = 0;
+
+    // 列出到期日在给定区间内的身份证信息, 到期日取有效日期 effectiveDate中的最后一个日期
+    // 参数: from/to - 起止日期(YYYY-MM-DD, 含两端), limit - 每页条数(默认20, 最大100), cursor - 上一页返回的游标
+    // 返回值: expiring - 按到期日排列的userid和到期日expiry, cursor - 存在下一页时返回, partial - 补齐前的旧记录未计入时为true(json格式string)
+    virtual void PoliceExpiringBetween() = 0;
+
+    // 按行政区划列出身份证信息, 区划由地址 address开头的 省/市/区县/街道乡镇 逐级解析
+    // 参数: code - 区划路径, 如 北京市/海淀区, 可到任一级为止; limit - 每页条数(默认20, 最大100), cursor - 上一页返回的游标
+    // 返回值: records - 按区划排列的userid和区划路径region, cursor - 存在下一页时返回, partial - 补齐前的旧记录未计入时为true(json格式string)
+    virtual void listPoliceByRegion() = 0;
 };
-class PoliceVar
-{
-public:
-    std::string name = "name";
-    std::string sex = "sex";
-    std::string nation = "nation";
-    std::string address = "address";
-    std::string effectiveDate = "effectiveDate";
-    std::string userid = "userid";
-};
-struct PoliceDemo : public Police, public xchain::Contract
-{
-private:
-    // define the key prefix of buckets
-    const std::string OWNER_KEY = "Owner";
-    const std::string RECORD_KEY = "R_";
-    std::string userid;
-
-    std::string score_key;
-    // check if caller is the owner of this contract
-    bool isOwner(xchain::Context *ctx, const std::string &caller)
-    {
-        std::string owner;
-        if (!ctx->get_object(OWNER_KEY, &owner))
-        {
-            return false;
-        }
-        return (owner == caller);
-    }
 
+struct PoliceDemo : public Police, public RecordContract<PoliceSchema>
+{
 public:
     void PoliceInitialize()
     {
-        // 获取合约上下文对象
-        xchain::Context *ctx = this->context();
-        // 从合约上下文中获取合约参数, 由合约部署者指定具有写入权限的sex
-        std::string owner = ctx->arg("owner");
-        if (owner.empty())
-        {
-            ctx->error("missing owner sex");
-            return;
-        }
-        // 将具有写入权限的owner地址记录在区块链账本中
-        ctx->put_object(OWNER_KEY, owner);
-        ctx->ok("success");
+        initializeOwner("PoliceInitialize");
     }
 
     void addPolice()
     {
-        PoliceData PoliceData;
-        PoliceVar PoliceVar;
-        // 获取合约上下文对象
-        xchain::Context *ctx = this->context();
-        // 获取发起者身份
-        const std::string &caller = ctx->initiator();
-        if (caller.empty())
-        {
-            ctx->error("missing initiator");
-            return;
-        }
-        // 如果写操作发起者不是具有写权限的用户，则无权写入
-        if (!isOwner(ctx, caller))
-        {
-            ctx->error(
-                "permission check failed, only the owner can add score record");
-            return;
-        }
-
-        // 从参数中获取用户主键id（身份证），必填参数，没有则返回错误
-        const std::string &userid = ctx->arg("userid");
-        if (userid.empty())
-        {
-            ctx->error("missing 'userid'");
-            return;
-        }
-        // 从参数中获取姓名，必填参数，没有则返回错误
-        PoliceData.name = ctx->arg("name");
-        if (PoliceData.name.empty())
-        {
-            ctx->error("missing 'name'");
-            return;
-        }
-        // 从参数中获取性别，必填参数，没有则返回错误
-        PoliceData.sex = ctx->arg("sex");
-        if (PoliceData.sex.empty())
-        {
-            ctx->error("missing 'sex'");
-            return;
-        }
-        // 从参数中获取民族，必填参数，没有则返回错误
-        PoliceData.nation = ctx->arg("nation");
-        if (PoliceData.nation.empty())
-        {
-            ctx->error("missing 'nation'");
-            return;
-        }
-        // 从参数中获取地址，必填参数，没有则返回错误
-        PoliceData.address = ctx->arg("address");
-        if (PoliceData.address.empty())
-        {
-            ctx->error("missing 'address'");
-            return;
-        }
-        // 从参数中获取有效时间，必填参数，没有则返回错误
-        PoliceData.effectiveDate = ctx->arg("effectiveDate");
-        if (PoliceData.effectiveDate.empty())
-        {
-            ctx->error("missing 'effectiveDate'");
-            return;
-        }
-
-        // 将具有写入权限的owner地址记录在区块链账本中
-        std::string score_key = RECORD_KEY + userid;
-
-       //json格式
-        std::string res = "{\"" + PoliceVar.name + "\":\"" + PoliceData.name + "\"," + "\"" + PoliceVar.sex + "\":\"" + PoliceData.sex + "\"," + "\"" + PoliceVar.nation + "\":\"" + PoliceData.nation + "\"," + "\"" + PoliceVar.address + "\":\"" + PoliceData.address + "\"," + "\"" + PoliceVar.effectiveDate + "\":\"" + PoliceData.effectiveDate + "\","+"\"" + PoliceVar.userid + "\":\"" + userid + "\"}";
-        /*if (!ctx->put_object(score_key, name， sex， nation， address， effectiveDate)) {
-            ctx->error("failed to save score record");*/
-        if (!ctx->put_object(score_key, res))
-        {
-            ctx->error("failed to save score record");
-            return;
-        }
-
-        // 执行成功，返回status code 200
-        ctx->ok(userid);
+        addRecord("addPolice");
     }
 
     void queryPolice()
     {
-        // 获取合约上下文对象
-        xchain::Context *ctx = this->context();
-        PoliceData PoliceData1;
-        PoliceVar PoliceVar1;
-        // 从参数中获取用户主键id，必填参数，没有则返回错误
-        const std::string &userid = ctx->arg("userid");
-        if (userid.empty())
-        {
-            ctx->error("missing 'userid'");
-            return;
-        }
-
-        // 从账本中读取身份证信息
-        std::string score_key = RECORD_KEY + userid;
-        std::string data;
-        //if (!ctx->get_object(score_key, &name, &sex, &nation, &address, &effectiveDate))
-        if (!ctx->get_object(score_key, &data))
-        {
-            // 没查到，说明之前没上链过，返回错误
-            ctx->error("no name record found of " + userid);
-            return;
-        }
-
-        ctx->ok(data);
+        queryRecord("queryPolice");
     }
 
     void PoliceQueryOwner()
     {
-        // 获取合约上下文对象
-        xchain::Context *ctx = this->context();
-        std::string owner;
-        if (!ctx->get_object(OWNER_KEY, &owner))
-        {
-            // 没查到owner信息，可能
-            ctx->error("get owner failed");
-            return;
-        }
-        // 执行成功，返回owner sex
-        ctx->ok(owner);
+        queryOwner("PoliceQueryOwner");
+    }
+
+    void addPoliceBatch()
+    {
+        addRecordBatch("addPoliceBatch");
+    }
+
+    void queryPoliceBatch()
+    {
+        queryRecordBatch("queryPoliceBatch");
+    }
+
+    void listPolice()
+    {
+        listRecords("listPolice");
+    }
+
+    void updatePolice()
+    {
+        updateRecord("updatePolice");
+    }
+
+    void queryStats()
+    {
+        queryCallStats();
+    }
+
+    void PoliceChangesSince()
+    {
+        changesSince("PoliceChangesSince");
+    }
+
+    void queryPoliceProof()
+    {
+        proveRecord("queryPoliceProof");
+    }
+
+    void existsPolice()
+    {
+        existsRecord("existsPolice");
+    }
+
+    void existsPoliceBatch()
+    {
+        existsRecordBatch("existsPoliceBatch");
+    }
+
+    void reindexPolice()
+    {
+        reindexRecords("reindexPolice");
+    }
+
+    void queryPoliceAt()
+    {
+        queryRecordAt("queryPoliceAt");
     }
-};
 
+    void queryPoliceHistory()
+    {
+        recordHistory("queryPoliceHistory");
+    }
 
-//学生
+    void PoliceExpiringBetween()
+    {
+        expiringBetween("PoliceExpiringBetween");
+    }
+
+    void listPoliceByRegion()
+    {
+        listByRegion("listPoliceByRegion");
+    }
+};
 
-DEFINE_METHOD(ScoreRecordDemo, initialize) { self.initialize(); }
-DEFINE_METHOD(ScoreRecordDemo, addScore) { self.addScore(); }
-DEFINE_METHOD(ScoreRecordDemo, queryScore) { self.queryScore(); }
-DEFINE_METHOD(ScoreRecordDemo,queryOwner) { self.queryOwner(); }
 
 //公安局
 DEFINE_METHOD(PoliceDemo, PoliceInitialize) { self.PoliceInitialize(); }
 DEFINE_METHOD(PoliceDemo, addPolice) { self.addPolice(); }
 DEFINE_METHOD(PoliceDemo, queryPolice) { self.queryPolice(); }
 DEFINE_METHOD(PoliceDemo, PoliceQueryOwner) { self.PoliceQueryOwner(); }
+DEFINE_METHOD(PoliceDemo, addPoliceBatch) { self.addPoliceBatch(); }
+DEFINE_METHOD(PoliceDemo, queryPoliceBatch) { self.queryPoliceBatch(); }
+DEFINE_METHOD(PoliceDemo, listPolice) { self.listPolice(); }
+DEFINE_METHOD(PoliceDemo, updatePolice) { self.updatePolice(); }
+DEFINE_METHOD(PoliceDemo, queryStats) { self.queryStats(); }
+DEFINE_METHOD(PoliceDemo, PoliceChangesSince) { self.PoliceChangesSince(); }
+DEFINE_METHOD(PoliceDemo, queryPoliceProof) { self.queryPoliceProof(); }
+DEFINE_METHOD(PoliceDemo, existsPolice) { self.existsPolice(); }
+DEFINE_METHOD(PoliceDemo, existsPoliceBatch) { self.existsPoliceBatch(); }
+DEFINE_METHOD(PoliceDemo, reindexPolice) { self.reindexPolice(); }
+DEFINE_METHOD(PoliceDemo, queryPoliceAt) { self.queryPoliceAt(); }
+DEFINE_METHOD(PoliceDemo, queryPoliceHistory) { self.queryPoliceHistory(); }
+DEFINE_METHOD(PoliceDemo, PoliceExpiringBetween) { self.PoliceExpiringBetween(); }
+DEFINE_METHOD(PoliceDemo, listPoliceByRegion) { self.listPoliceByRegion(); }
 
 
@@ -1,135 +1,7 @@
 #include "xchain/xchain.h"
 
-// 学生成绩上链存证API规范
-// 参数由Context提供
-class ScoreRecord {
-public:
-    // 初始化写入权限
-    // 参数: owner - 具有写入权限的address
-    virtual void initialize() = 0;
-
-    // 写入课程成绩
-    // 参数: userid - 学生的主键id
-    //      data - 学生的成绩信息(json格式string)
-    virtual void addScore() = 0;
-
-    // 按照学生id查询成绩
-    // 参数: userid - 学生的主键id
-    // 返回值: data - 学生的成绩信息(json格式string)
-    virtual void queryScore() = 0;
-
-    // 查询具有写权限的账户
-    // 返回值: 具有写权限的address
-    virtual void queryOwner() = 0;
-};
-
-struct ScoreRecordDemo : public ScoreRecord, public xchain::Contract {
-private:
-    // define the key prefix of buckets
-    const std::string OWNER_KEY = "Owner";
-    const std::string RECORD_KEY = "R_";
-
-    // check if caller is the owner of this contract
-    bool isOwner(xchain::Context* ctx, const std::string& caller) {
-        std::string owner;
-        if (!ctx->get_object(OWNER_KEY, &owner)) {
-            return false;
-        }
-        return (owner == caller);
-    }
-
-public:
-    void initialize() {
-        // 获取合约上下文对象
-        xchain::Context* ctx = this->context();
-        // 从合约上下文中获取合约参数, 由合约部署者指定具有写入权限的address
-        std::string owner = ctx->arg("owner");
-        if (owner.empty()) {
-            ctx->error("missing owner address");
-            return;
-        }
-        // 将具有写入权限的owner地址记录在区块链账本中
-        ctx->put_object(OWNER_KEY, owner);
-        ctx->ok("success");
-    }
-
-    void addScore() {
-        // 获取合约上下文对象
-        xchain::Context* ctx = this->context();
-        // 获取发起者身份
-        const std::string& caller = ctx->initiator();
-        if (caller.empty()) {
-            ctx->error("missing initiator");
-            return;
-        }
-        // 如果写操作发起者不是具有写权限的用户，则无权写入
-        if (!isOwner(ctx, caller)) {
-            ctx->error(
-                "permission check failed, only the owner can add score record");
-            return;
-        }
-
-        // 从参数中获取用户主键id，必填参数，没有则返回错误
-        const std::string& userid = ctx->arg("userid");
-        if (userid.empty()) {
-            ctx->error("missing 'userid'");
-            return;
-        }
-        // 从参数中获取成绩数据，必填参数，没有则返回错误
-        const std::string& data = ctx->arg("data");
-        if (data.empty()) {
-            ctx->error("missing 'data'");
-            return;
-        }
-
-        // 将具有写入权限的owner地址记录在区块链账本中
-        std::string score_key = RECORD_KEY + userid;
-        if (!ctx->put_object(score_key, data)) {
-            ctx->error("failed to save score record");
-            return;
-        }
-
-        // 执行成功，返回status code 200
-        ctx->ok(userid);
-    }
-
-    void queryScore() {
-        // 获取合约上下文对象
-        xchain::Context* ctx = this->context();
-
-        // 从参数中获取用户主键id，必填参数，没有则返回错误
-        const std::string& userid = ctx->arg("userid");
-        if (userid.empty()) {
-            ctx->error("missing 'userid'");
-            return;
-        }
-
-        // 从账本中读取学生的成绩数据
-        std::string score_key = RECORD_KEY + userid;
-        std::string data;
-        if (!ctx->get_object(score_key, &data)) {
-            // 没查到，说明之前没上链过，返回错误
-            ctx->error("no score record found of " + userid);
-            return;
-        }
-
-        // 执行成功，返回status code 200
-        ctx->ok(data);
-    }
-
-    void queryOwner() {
-        // 获取合约上下文对象
-        xchain::Context* ctx = this->context();
-        std::string owner;
-        if (!ctx->get_object(OWNER_KEY, &owner)) {
-            // 没查到owner信息，可能
-            ctx->error("get owner failed");
-            return;
-        }
-        // 执行成功，返回owner address
-        ctx->ok(owner);
-    }
-};
+#include "agency_schemas.h"
+#include "record_contract.h"
 
 // 国土资源局存证上链存证API规范
 // 参数由Context提供
@@ -148,199 +20,220 @@ public:
 
     // 按照身份证查询土地使用证信息
     // 参数: userid - 土地使用证的主键
+    // 可选参数: fields - 逗号分隔的字段名, 只返回这些字段(userid总是返回)
     // 返回值: data - 土地使用证数据信息(json格式string)
     virtual void queryLand() = 0;
 
     // 查询具有写权限的账户
     // 返回值: 具有写权限的address
     virtual void LandQueryOwner() = 0;
-};
 
-class LandData
-{
-public:
-    std::string useName;
-    std::string address;
-    std::string landNumber;
-    std::string purpose;
-    std::string serviceLife;
-};
-class LandVar
-{
-public:
-    std::string useName = "useName";
-    std::string address = "address";
-    std::string landNumber = "landNumber";
-    std::string purpose = "purpose";
-    std::string serviceLife = "serviceLife";
-    std::string userid = "userid";
+    // 批量写入土地使用证
+    // 参数: records - 记录数组(json格式string), 每个元素包含userid及全部字段
+    // 返回值: 每条记录的写入结果(json格式string), 单条不合法不影响其余记录
+    virtual void addLandBatch() = 0;
+
+    // 批量查询土地使用证
+    // 参数: userids - 主键数组(json格式string)
+    // 可选参数: fields - 逗号分隔的字段名, 只返回这些字段(userid总是返回)
+    // 返回值: records - 查到的记录数组, missing - 未查到的主键数组(json格式string)
+    virtual void queryLandBatch() = 0;
+
+    // 按地号查询土地使用证
+    // 参数: landNumber - 地号
+    // 可选参数: fields - 逗号分隔的字段名, 只返回这些字段(userid总是返回)
+    // 返回值: records - 该地号的土地使用证, partial - 补齐前的旧记录可能未计入时为true(json格式string)
+    virtual void queryLandByLandNumber() = 0;
+
+    // 分页列举土地使用证
+    // 参数: limit - 每页条数(默认20, 最大100), cursor - 上一页返回的游标, keysOnly - 为true时只返回主键
+    // 可选参数: fields - 逗号分隔的字段名, 只返回这些字段(userid总是返回)
+    // 返回值: records/userids - 本页数据, cursor - 存在下一页时返回(json格式string)
+    virtual void listLand() = 0;
+
+    // 部分更新土地使用证, 只需传入要修改的字段
+    // 参数: userid - 主键id（身份证）, 其余为要修改的字段, 未传入的字段保持不变
+    // 返回值: userid及更新后的记录版本号version(json格式string)
+    virtual void updateLand() = 0;
+
+    // 查询各方法累计的资源消耗, 只累计带了参数 stats=true 并写了账本的调用
+    // 返回值: stats - 每个方法的调用次数calls、账本读写次数reads/writes、读写字节数bytesRead/bytesWritten、遍历步数iteratorSteps(json格式string)
+    virtual void queryStats() = 0;
+
+    // 按序号增量同步土地使用证的变更
+    // 参数: seq - 上次同步到的序号(缺省为0), limit - 每页条数(默认20, 最大100)
+    // 返回值: changes - seq之后按序号排列的变更(seq、userid、version), seq - 本页最后的序号, more - 还有后续时为true(json格式string)
+    virtual void LandChangesSince() = 0;
+
+    // 查询土地使用证的 Merkle 包含证明, 第三方可据此单独验证一条记录
+    // 参数: userid - 主键id（身份证）
+    // 返回值: index - 叶子编号, leaves - 叶子总数, leaf/root - 叶子和根哈希, siblings - 自下而上的兄弟节点哈希(json格式string)
+    // 验证: 叶子为 sha256(0x00 || 查询该记录返回的json), 依次与兄弟节点按 sha256(0x01 || 左 || 右) 合并, 结果应等于 root
+    virtual void queryLandProof() = 0;
+
+    // 查询土地使用证是否存在, 不读取记录内容
+    // 参数: userid - 主键id（身份证）
+    // 返回值: userid及是否存在exists(json格式string)
+    virtual void existsLand() = 0;
+
+    // 批量查询土地使用证是否存在
+    // 参数: userids - 主键数组(json格式string)
+    // 返回值: found - 存在的主键数组, missing - 不存在的主键数组(json格式string)
+    virtual void existsLandBatch() = 0;
+
+    // 为升级前写入的土地使用证补齐二级索引、存在性过滤器、Merkle 树、分组汇总、到期索引和区划索引, 需分页调用到没有cursor返回为止
+    // 参数: limit - 每页条数(默认20, 最大100), cursor - 上一页返回的游标
+    // 返回值: reindexed - 本页处理的条数, cursor - 存在下一页时返回(json格式string)
+    virtual void reindexLand() = 0;
+
+    // 按用途汇总土地使用证, 只读取固定数量的汇总分块, 不遍历记录
+    // 参数: purpose - 用途
+    // 返回值: purpose, count - 记录数; 补齐前的旧记录未计入时带 partial(json格式string)
+    virtual void queryLandAggregate() = 0;
+
+    // 查询土地使用证的某个历史版本
+    // 参数: userid - 主键id（身份证）, version - 版本号, fields - 逗号分隔的字段名(可选, 缺省返回全部字段)
+    // 返回值: 该版本的土地使用证, 格式与查询当前版本相同(json格式string)
+    virtual void queryLandAt() = 0;
+
+    // 查询土地使用证的修订历史, 从新到旧排列
+    // 参数: userid - 主键id（身份证）, limit - 条数(默认20, 最大100), before - 只返回小于该版本号的修订(可选)
+    // 返回值: revisions - 各修订的版本号version、变更序号seq和当时的记录record, more - 还有更早的修订时为true(json格式string)
+    virtual void queryLandHistory() = 0;
+
+    // 列出到期日在给定区间内的土地使用证, 到期日取使用期限 serviceLife中的最后一个日期
+    // 参数: from/to - 起止日期(YYYY-MM-DD, 含两端), limit - 每页条数(默认20, 最大100), cursor - 上一页返回的游标
+    // 返回值: expiring - 按到期日排列的userid和到期日expiry, cursor - 存在下一页时返回, partial - 补齐前的旧记录未计入时为true(json格式string)
+    virtual void LandExpiringBetween() = 0;
+
+    // 按行政区划列出土地使用证, 区划由地址 address开头的 省/市/区县/街道乡镇 逐级解析
+    // 参数: code - 区划路径, 如 北京市/海淀区, 可到任一级为止; limit - 每页条数(默认20, 最大100), cursor - 上一页返回的游标
+    // 返回值: records - 按区划排列的userid和区划路径region, cursor - 存在下一页时返回, partial - 补齐前的旧记录未计入时为true(json格式string)
+    virtual void listLandByRegion() = 0;
 };
-struct LandDemo : public Land, public xchain::Contract
-{
-private:
-    // define the key prefix of buckets
-    const std::string OWNER_KEY = "Owner";
-    const std::string RECORD_KEY = "R_";
-    std::string userid;
-
-    std::string score_key;
-    // check if caller is the owner of this contract
-    bool isOwner(xchain::Context *ctx, const std::string &caller)
-    {
-        std::string owner;
-        if (!ctx->get_object(OWNER_KEY, &owner))
-        {
-            return false;
-        }
-        return (owner == caller);
-    }
 
+struct LandDemo : public Land, public RecordContract<LandSchema>
+{
 public:
     void LandInitialize()
     {
-        // 获取合约上下文对象
-        xchain::Context *ctx = this->context();
-        // 从合约上下文中获取合约参数, 由合约部署者指定具有写入权限的address
-        std::string owner = ctx->arg("owner");
-        if (owner.empty())
-        {
-            ctx->error("missing owner address");
-            return;
-        }
-        // 将具有写入权限的owner地址记录在区块链账本中
-        ctx->put_object(OWNER_KEY, owner);
-        ctx->ok("success");
+        initializeOwner("LandInitialize");
     }
 
     void addLand()
     {
-        LandData LandData;
-        LandVar LandVar;
-        // 获取合约上下文对象
-        xchain::Context *ctx = this->context();
-        // 获取发起者身份
-        const std::string &caller = ctx->initiator();
-        if (caller.empty())
-        {
-            ctx->error("missing initiator");
-            return;
-        }
-        // 如果写操作发起者不是具有写权限的用户，则无权写入
-        if (!isOwner(ctx, caller))
-        {
-            ctx->error(
-                "permission check failed, only the owner can add score record");
-            return;
-        }
-
-        // 从参数中获取土地使用证的主键，必填参数，没有则返回错误
-        const std::string &userid = ctx->arg("userid");
-        if (userid.empty())
-        {
-            ctx->error("missing 'userid'");
-            return;
-        }
-        // 从参数中获取使用者名称，必填参数，没有则返回错误
-        LandData.useName = ctx->arg("useName");
-        if (LandData.useName.empty())
-        {
-            ctx->error("missing 'useName'");
-            return;
-        }
-        // 从参数中获取地址，必填参数，没有则返回错误
-        LandData.address = ctx->arg("address");
-        if (LandData.address.empty())
-        {
-            ctx->error("missing 'address'");
-            return;
-        }
-        // 从参数中获取地号，必填参数，没有则返回错误
-        LandData.landNumber = ctx->arg("landNumber");
-        if (LandData.landNumber.empty())
-        {
-            ctx->error("missing 'landNumber'");
-            return;
-        }
-        // 从参数中获取用途，必填参数，没有则返回错误
-        LandData.purpose = ctx->arg("purpose");
-        if (LandData.purpose.empty())
-        {
-            ctx->error("missing 'purpose'");
-            return;
-        }
-        // 从参数中获取使用期限，必填参数，没有则返回错误
-        LandData.serviceLife = ctx->arg("serviceLife");
-        if (LandData.serviceLife.empty())
-        {
-            ctx->error("missing 'serviceLife'");
-            return;
-        }
-
-        // 将具有写入权限的owner地址记录在区块链账本中
-        std::string score_key = RECORD_KEY + userid;
-
-        std::string res = "{\"" + LandVar.useName + "\":\"" + LandData.useName + "\"," + "\"" + LandVar.address + "\":\"" + LandData.address + "\"," + "\"" + LandVar.landNumber + "\":\"" + LandData.landNumber + "\"," + "\"" + LandVar.purpose + "\":\"" + LandData.purpose + "\"," + "\"" + LandVar.serviceLife + "\":\"" + LandData.serviceLife +  "\","+"\"" + LandVar.userid + "\":\"" + userid + "\"}";
-        if (!ctx->put_object(score_key, res))
-        {
-            ctx->error("failed to save score record");
-            return;
-        }
-
-        // 执行成功，返回status code 200
-        ctx->ok(userid);
+        addRecord("addLand");
     }
 
     void queryLand()
     {
-        // 获取合约上下文对象
-        xchain::Context *ctx = this->context();
-        LandData LandData1;
-        LandVar LandVar1;
-        // 从参数中获取土地使用证主键，必填参数，没有则返回错误
-        const std::string &userid = ctx->arg("userid");
-        if (userid.empty())
-        {
-            ctx->error("missing 'userid'");
-            return;
-        }
-
-        // 从账本中读取土地使用证的数据
-        std::string score_key = RECORD_KEY + userid;
-        std ::string data;
-        if (!ctx->get_object(score_key, &data))
-        {
-            // 没查到，说明之前没上链过，返回错误
-            ctx->error("no useName record found of " + userid);
-            return;
-        }
-
-        ctx->ok(data);
+        queryRecord("queryLand");
     }
 
     void LandQueryOwner()
     {
-        // 获取合约上下文对象
-        xchain::Context *ctx = this->context();
-        std::string owner;
-        if (!ctx->get_object(OWNER_KEY, &owner))
-        {
-            // 没查到owner信息，可能
-            ctx->error("get owner failed");
-            return;
-        }
-        // 执行成功，返回owner address
-        ctx->ok(owner);
+        queryOwner("LandQueryOwner");
+    }
+
+    void addLandBatch()
+    {
+        addRecordBatch("addLandBatch");
     }
-};
 
-//学生
-DEFINE_METHOD(ScoreRecordDemo, initialize) { self.initialize(); }
-DEFINE_METHOD(ScoreRecordDemo, addScore) { self.addScore(); }
-DEFINE_METHOD(ScoreRecordDemo, queryScore) { self.queryScore(); }
-DEFINE_METHOD(ScoreRecordDemo, queryOwner) { self.queryOwner(); }
+    void queryLandBatch()
+    {
+        queryRecordBatch("queryLandBatch");
+    }
+
+    void queryLandByLandNumber()
+    {
+        queryRecordBy("queryLandByLandNumber", "landNumber");
+    }
+
+    void listLand()
+    {
+        listRecords("listLand");
+    }
+
+    void updateLand()
+    {
+        updateRecord("updateLand");
+    }
+
+    void queryStats()
+    {
+        queryCallStats();
+    }
+
+    void LandChangesSince()
+    {
+        changesSince("LandChangesSince");
+    }
+
+    void queryLandProof()
+    {
+        proveRecord("queryLandProof");
+    }
+
+    void existsLand()
+    {
+        existsRecord("existsLand");
+    }
+
+    void existsLandBatch()
+    {
+        existsRecordBatch("existsLandBatch");
+    }
+
+    void reindexLand()
+    {
+        reindexRecords("reindexLand");
+    }
+
+    void queryLandAggregate()
+    {
+        queryAggregate("queryLandAggregate", "purpose");
+    }
+
+    void queryLandAt()
+    {
+        queryRecordAt("queryLandAt");
+    }
+
+    void queryLandHistory()
+    {
+        recordHistory("queryLandHistory");
+    }
+
+    void LandExpiringBetween()
+    {
+        expiringBetween("LandExpiringBetween");
+    }
+
+    void listLandByRegion()
+    {
+        listByRegion("listLandByRegion");
+    }
+};
 
 //国土资源局
 DEFINE_METHOD(LandDemo, LandInitialize) { self.LandInitialize(); }
 DEFINE_METHOD(LandDemo, addLand) { self.addLand(); }
 DEFINE_METHOD(LandDemo, queryLand) { self.queryLand(); }
-DEFINE_METHOD(LandDemo, LandQueryOwner) { self.LandQueryOwner(); }
\ No newline at end of file
+DEFINE_METHOD(LandDemo, LandQueryOwner) { self.LandQueryOwner(); }
+DEFINE_METHOD(LandDemo, addLandBatch) { self.addLandBatch(); }
+DEFINE_METHOD(LandDemo, queryLandBatch) { self.queryLandBatch(); }
+DEFINE_METHOD(LandDemo, queryLandByLandNumber) { self.queryLandByLandNumber(); }
+DEFINE_METHOD(LandDemo, listLand) { self.listLand(); }
+DEFINE_METHOD(LandDemo, updateLand) { self.updateLand(); }
+DEFINE_METHOD(LandDemo, queryStats) { self.queryStats(); }
+DEFINE_METHOD(LandDemo, LandChangesSince) { self.LandChangesSince(); }
+DEFINE_METHOD(LandDemo, queryLandProof) { self.queryLandProof(); }
+DEFINE_METHOD(LandDemo, existsLand) { self.existsLand(); }
+DEFINE_METHOD(LandDemo, existsLandBatch) { self.existsLandBatch(); }
+DEFINE_METHOD(LandDemo, reindexLand) { self.reindexLand(); }
+DEFINE_METHOD(LandDemo, queryLandAggregate) { self.queryLandAggregate(); }
+DEFINE_METHOD(LandDemo, queryLandAt) { self.queryLandAt(); }
+DEFINE_METHOD(LandDemo, queryLandHistory) { self.queryLandHistory(); }
+DEFINE_METHOD(LandDemo, LandExpiringBetween) { self.LandExpiringBetween(); }
+DEFINE_METHOD(LandDemo, listLandByRegion) { self.listLandByRegion(); }
\ No newline at end of file
@@ -1,135 +1,7 @@
 #include "xchain/xchain.h"
 
-// 学生成绩上链存证API规范
-// 参数由Context提供
-class ScoreRecord {
-public:
-    // 初始化写入权限
-    // 参数: owner - 具有写入权限的address
-    virtual void initialize() = 0;
-
-    // 写入课程成绩
-    // 参数: userid - 学生的主键id
-    //      data - 学生的成绩信息(json格式string)
-    virtual void addScore() = 0;
-
-    // 按照学生id查询成绩
-    // 参数: userid - 学生的主键id
-    // 返回值: data - 学生的成绩信息(json格式string)
-    virtual void queryScore() = 0;
-
-    // 查询具有写权限的账户
-    // 返回值: 具有写权限的address
-    virtual void queryOwner() = 0;
-};
-
-struct ScoreRecordDemo : public ScoreRecord, public xchain::Contract {
-private:
-    // define the key prefix of buckets
-    const std::string OWNER_KEY = "Owner";
-    const std::string RECORD_KEY = "R_";
-
-    // check if caller is the owner of this contract
-    bool isOwner(xchain::Context* ctx, const std::string& caller) {
-        std::string owner;
-        if (!ctx->get_object(OWNER_KEY, &owner)) {
-            return false;
-        }
-        return (owner == caller);
-    }
-
-public:
-    void initialize() {
-        // 获取合约上下文对象
-        xchain::Context* ctx = this->context();
-        // 从合约上下文中获取合约参数, 由合约部署者指定具有写入权限的address
-        std::string owner = ctx->arg("owner");
-        if (owner.empty()) {
-            ctx->error("missing owner address");
-            return;
-        }
-        // 将具有写入权限的owner地址记录在区块链账本中
-        ctx->put_object(OWNER_KEY, owner);
-        ctx->ok("success");
-    }
-
-    void addScore() {
-        // 获取合约上下文对象
-        xchain::Context* ctx = this->context();
-        // 获取发起者身份
-        const std::string& caller = ctx->initiator();
-        if (caller.empty()) {
-            ctx->error("missing initiator");
-            return;
-        }
-        // 如果写操作发起者不是具有写权限的用户，则无权写入
-        if (!isOwner(ctx, caller)) {
-            ctx->error(
-                "permission check failed, only the owner can add score record");
-            return;
-        }
-
-        // 从参数中获取用户主键id，必填参数，没有则返回错误
-        const std::string& userid = ctx->arg("userid");
-        if (userid.empty()) {
-            ctx->error("missing 'userid'");
-            return;
-        }
-        // 从参数中获取成绩数据，必填参数，没有则返回错误
-        const std::string& data = ctx->arg("data");
-        if (data.empty()) {
-            ctx->error("missing 'data'");
-            return;
-        }
-
-        // 将具有写入权限的owner地址记录在区块链账本中
-        std::string score_key = RECORD_KEY + userid;
-        if (!ctx->put_object(score_key, data)) {
-            ctx->error("failed to save score record");
-            return;
-        }
-
-        // 执行成功，返回status code 200
-        ctx->ok(userid);
-    }
-
-    void queryScore() {
-        // 获取合约上下文对象
-        xchain::Context* ctx = this->context();
-
-        // 从参数中获取用户主键id，必填参数，没有则返回错误
-        const std::string& userid = ctx->arg("userid");
-        if (userid.empty()) {
-            ctx->error("missing 'userid'");
-            return;
-        }
-
-        // 从账本中读取学生的成绩数据
-        std::string score_key = RECORD_KEY + userid;
-        std::string data;
-        if (!ctx->get_object(score_key, &data)) {
-            // 没查到，说明之前没上链过，返回错误
-            ctx->error("no score record found of " + userid);
-            return;
-        }
-
-        // 执行成功，返回status code 200
-        ctx->ok(data);
-    }
-
-    void queryOwner() {
-        // 获取合约上下文对象
-        xchain::Context* ctx = this->context();
-        std::string owner;
-        if (!ctx->get_object(OWNER_KEY, &owner)) {
-            // 没查到owner信息，可能
-            ctx->error("get owner failed");
-            return;
-        }
-        // 执行成功，返回owner address
-        ctx->ok(owner);
-    }
-};
+#include "agency_schemas.h"
+#include "record_contract.h"
 
 // 城乡规划部存证上链存证API规范
 // 参数由Context提供
@@ -148,199 +20,186 @@ public:
 
     // 按照身份证查询规划许可证
     // 参数: userid：身份证
+    // 可选参数: fields - 逗号分隔的字段名, 只返回这些字段(userid总是返回)
     // 返回值: data - 规划许可证信息(json格式string)
     virtual void queryUrbanRural() = 0;
 
     // 查询具有写权限的账户
     // 返回值: 具有写权限的address
     virtual void UrbanRuralQueryOwner() = 0;
-};
 
-class UrbanRuralData
-{
-public:
-    std::string buildUnite;
-    std::string projectname;
-    std::string buildLocation;
-    std::string buildScale;
-    std::string issueDate;
-};
-class UrbanRuralVar
-{
-public:
-    std::string buildUnite = "buildUnite";
-    std::string projectname = "projectname";
-    std::string buildLocation = "buildLocation";
-    std::string buildScale = "buildScale";
-    std::string issueDate = "issueDate";
-    std::string userid = "userid";
+    // 批量写入规划许可证
+    // 参数: records - 记录数组(json格式string), 每个元素包含userid及全部字段
+    // 返回值: 每条记录的写入结果(json格式string), 单条不合法不影响其余记录
+    virtual void addUrbanRuralBatch() = 0;
+
+    // 批量查询规划许可证
+    // 参数: userids - 主键数组(json格式string)
+    // 可选参数: fields - 逗号分隔的字段名, 只返回这些字段(userid总是返回)
+    // 返回值: records - 查到的记录数组, missing - 未查到的主键数组(json格式string)
+    virtual void queryUrbanRuralBatch() = 0;
+
+    // 分页列举规划许可证
+    // 参数: limit - 每页条数(默认20, 最大100), cursor - 上一页返回的游标, keysOnly - 为true时只返回主键
+    // 可选参数: fields - 逗号分隔的字段名, 只返回这些字段(userid总是返回)
+    // 返回值: records/userids - 本页数据, cursor - 存在下一页时返回(json格式string)
+    virtual void listUrbanRural() = 0;
+
+    // 部分更新规划许可证, 只需传入要修改的字段
+    // 参数: userid - 主键id（身份证）, 其余为要修改的字段, 未传入的字段保持不变
+    // 返回值: userid及更新后的记录版本号version(json格式string)
+    virtual void updateUrbanRural() = 0;
+
+    // 查询各方法累计的资源消耗, 只累计带了参数 stats=true 并写了账本的调用
+    // 返回值: stats - 每个方法的调用次数calls、账本读写次数reads/writes、读写字节数bytesRead/bytesWritten、遍历步数iteratorSteps(json格式string)
+    virtual void queryStats() = 0;
+
+    // 按序号增量同步规划许可证的变更
+    // 参数: seq - 上次同步到的序号(缺省为0), limit - 每页条数(默认20, 最大100)
+    // 返回值: changes - seq之后按序号排列的变更(seq、userid、version), seq - 本页最后的序号, more - 还有后续时为true(json格式string)
+    virtual void UrbanRuralChangesSince() = 0;
+
+    // 查询规划许可证的 Merkle 包含证明, 第三方可据此单独验证一条记录
+    // 参数: userid - 主键id（身份证）
+    // 返回值: index - 叶子编号, leaves - 叶子总数, leaf/root - 叶子和根哈希, siblings - 自下而上的兄弟节点哈希(json格式string)
+    // 验证: 叶子为 sha256(0x00 || 查询该记录返回的json), 依次与兄弟节点按 sha256(0x01 || 左 || 右) 合并, 结果应等于 root
+    virtual void queryUrbanRuralProof() = 0;
+
+    // 查询规划许可证是否存在, 不读取记录内容
+    // 参数: userid - 主键id（身份证）
+    // 返回值: userid及是否存在exists(json格式string)
+    virtual void existsUrbanRural() = 0;
+
+    // 批量查询规划许可证是否存在
+    // 参数: userids - 主键数组(json格式string)
+    // 返回值: found - 存在的主键数组, missing - 不存在的主键数组(json格式string)
+    virtual void existsUrbanRuralBatch() = 0;
+
+    // 为升级前写入的规划许可证补齐存在性过滤器、Merkle 树和区划索引, 需分页调用到没有cursor返回为止
+    // 参数: limit - 每页条数(默认20, 最大100), cursor - 上一页返回的游标
+    // 返回值: reindexed - 本页处理的条数, cursor - 存在下一页时返回(json格式string)
+    virtual void reindexUrbanRural() = 0;
+
+    // 查询规划许可证的某个历史版本
+    // 参数: userid - 主键id（身份证）, version - 版本号, fields - 逗号分隔的字段名(可选, 缺省返回全部字段)
+    // 返回值: 该版本的规划许可证, 格式与查询当前版本相同(json格式string)
+    virtual void queryUrbanRuralAt() = 0;
+
+    // 查询规划许可证的修订历史, 从新到旧排列
+    // 参数: userid - 主键id（身份证）, limit - 条数(默认20, 最大100), before - 只返回小于该版本号的修订(可选)
+    // 返回值: revisions - 各修订的版本号version、变更序号seq和当时的记录record, more - 还有更早的修订时为true(json格式string)
+    virtual void queryUrbanRuralHistory() = 0;
+
+    // 按行政区划列出规划许可证, 区划由建设位置 buildLocation开头的 省/市/区县/街道乡镇 逐级解析
+    // 参数: code - 区划路径, 如 北京市/海淀区, 可到任一级为止; limit - 每页条数(默认20, 最大100), cursor - 上一页返回的游标
+    // 返回值: records - 按区划排列的userid和区划路径region, cursor - 存在下一页时返回, partial - 补齐前的旧记录未计入时为true(json格式string)
+    virtual void listUrbanRuralByRegion() = 0;
 };
-struct UrbanRuralDemo : public UrbanRural, public xchain::Contract
-{
-private:
-    // define the key prefix of buckets
-    const std::string OWNER_KEY = "Owner";
-    const std::string RECORD_KEY = "R_";
-    std::string userid;
-
-    std::string score_key;
-    // check if caller is the owner of this contract
-    bool isOwner(xchain::Context *ctx, const std::string &caller)
-    {
-        std::string owner;
-        if (!ctx->get_object(OWNER_KEY, &owner))
-        {
-            return false;
-        }
-        return (owner == caller);
-    }
 
+struct UrbanRuralDemo : public UrbanRural, public RecordContract<UrbanRuralSchema>
+{
 public:
     void UrbanRuralInitialize()
     {
-        // 获取合约上下文对象
-        xchain::Context *ctx = this->context();
-        // 从合约上下文中获取合约参数, 由合约部署者指定具有写入权限的projectname
-        std::string owner = ctx->arg("owner");
-        if (owner.empty())
-        {
-            ctx->error("missing owner projectname");
-            return;
-        }
-        // 将具有写入权限的owner地址记录在区块链账本中
-        ctx->put_object(OWNER_KEY, owner);
-        ctx->ok("success");
+        initializeOwner("UrbanRuralInitialize");
     }
 
     void addUrbanRural()
     {
-        UrbanRuralData UrbanRuralData;
-        UrbanRuralVar UrbanRuralVar;
-        // 获取合约上下文对象
-        xchain::Context *ctx = this->context();
-        // 获取发起者身份
-        const std::string &caller = ctx->initiator();
-        if (caller.empty())
-        {
-            ctx->error("missing initiator");
-            return;
-        }
-        // 如果写操作发起者不是具有写权限的用户，则无权写入
-        if (!isOwner(ctx, caller))
-        {
-            ctx->error(
-                "permission check failed, only the owner can add score record");
-            return;
-        }
-
-        // 从参数中获取规划许可证主键，必填参数，没有则返回错误
-        const std::string &userid = ctx->arg("userid");
-        if (userid.empty())
-        {
-            ctx->error("missing 'userid'");
-            return;
-        }
-        // 从参数中获取建设单位，必填参数，没有则返回错误
-        UrbanRuralData.buildUnite = ctx->arg("buildUnite");
-        if (UrbanRuralData.buildUnite.empty())
-        {
-            ctx->error("missing 'buildUnite'");
-            return;
-        }
-        // 从参数中获取项目名称，必填参数，没有则返回错误
-        UrbanRuralData.projectname = ctx->arg("projectname");
-        if (UrbanRuralData.projectname.empty())
-        {
-            ctx->error("missing 'projectname'");
-            return;
-        }
-        // 从参数中获取建设位置，必填参数，没有则返回错误
-        UrbanRuralData.buildLocation = ctx->arg("buildLocation");
-        if (UrbanRuralData.buildLocation.empty())
-        {
-            ctx->error("missing 'buildLocation'");
-            return;
-        }
-        // 从参数中获取建设规模，必填参数，没有则返回错误
-        UrbanRuralData.buildScale = ctx->arg("buildScale");
-        if (UrbanRuralData.buildScale.empty())
-        {
-            ctx->error("missing 'buildScale'");
-            return;
-        }
-        // 从参数中获取签发日期，必填参数，没有则返回错误
-        UrbanRuralData.issueDate = ctx->arg("issueDate");
-        if (UrbanRuralData.issueDate.empty())
-        {
-            ctx->error("missing 'issueDate'");
-            return;
-        }
-
-        // 将具有写入权限的owner地址记录在区块链账本中
-        std::string score_key = RECORD_KEY + userid;
-
-        std::string res = "{\"" + UrbanRuralVar.buildUnite + "\":\"" + UrbanRuralData.buildUnite + "\"," + "\"" + UrbanRuralVar.projectname + "\":\"" + UrbanRuralData.projectname + "\"," + "\"" + UrbanRuralVar.buildLocation + "\":\"" + UrbanRuralData.buildLocation + "\"," + "\"" + UrbanRuralVar.buildScale + "\":\"" + UrbanRuralData.buildScale + "\"," + "\"" + UrbanRuralVar.issueDate + "\":\"" + UrbanRuralData.issueDate + "\","+"\"" + UrbanRuralVar.userid + "\":\"" + userid + "\"}";
-        if (!ctx->put_object(score_key, res))
-        {
-            ctx->error("failed to save score record");
-            return;
-        }
-
-        // 执行成功，返回status code 200
-        ctx->ok(userid);
+        addRecord("addUrbanRural");
     }
 
     void queryUrbanRural()
     {
-        // 获取合约上下文对象
-        xchain::Context *ctx = this->context();
-        UrbanRuralData UrbanRuralData1;
-        UrbanRuralVar UrbanRuralVar1;
-        // 从参数中获取身份证主键，必填参数，没有则返回错误
-        const std::string &userid = ctx->arg("userid");
-        if (userid.empty())
-        {
-            ctx->error("missing 'userid'");
-            return;
-        }
-
-        // 从账本中读取规划许可证的数据
-        std::string score_key = RECORD_KEY + userid;
-        std::string data;
-        if (!ctx->get_object(score_key, &data))
-        {
-            // 没查到，说明之前没上链过，返回错误
-            ctx->error("no buildUnite record found of " + userid);
-            return;
-        }
-
-        ctx->ok(data);
+        queryRecord("queryUrbanRural");
     }
 
     void UrbanRuralQueryOwner()
     {
-        // 获取合约上下文对象
-        xchain::Context *ctx = this->context();
-        std::string owner;
-        if (!ctx->get_object(OWNER_KEY, &owner))
-        {
-            // 没查到owner信息，可能
-            ctx->error("get owner failed");
-            return;
-        }
-        // 执行成功，返回owner projectname
-        ctx->ok(owner);
+        queryOwner("UrbanRuralQueryOwner");
+    }
+
+    void addUrbanRuralBatch()
+    {
+        addRecordBatch("addUrbanRuralBatch");
     }
-};
 
-//学生
-DEFINE_METHOD(ScoreRecordDemo, initialize) { self.initialize(); }
-DEFINE_METHOD(ScoreRecordDemo, addScore) { self.addScore(); }
-DEFINE_METHOD(ScoreRecordDemo, queryScore) { self.queryScore(); }
-DEFINE_METHOD(ScoreRecordDemo, queryOwner) { self.queryOwner(); }
+    void queryUrbanRuralBatch()
+    {
+        queryRecordBatch("queryUrbanRuralBatch");
+    }
+
+    void listUrbanRural()
+    {
+        listRecords("listUrbanRural");
+    }
+
+    void updateUrbanRural()
+    {
+        updateRecord("updateUrbanRural");
+    }
+
+    void queryStats()
+    {
+        queryCallStats();
+    }
+
+    void UrbanRuralChangesSince()
+    {
+        changesSince("UrbanRuralChangesSince");
+    }
+
+    void queryUrbanRuralProof()
+    {
+        proveRecord("queryUrbanRuralProof");
+    }
+
+    void existsUrbanRural()
+    {
+        existsRecord("existsUrbanRural");
+    }
+
+    void existsUrbanRuralBatch()
+    {
+        existsRecordBatch("existsUrbanRuralBatch");
+    }
+
+    void reindexUrbanRural()
+    {
+        reindexRecords("reindexUrbanRural");
+    }
+
+    void queryUrbanRuralAt()
+    {
+        queryRecordAt("queryUrbanRuralAt");
+    }
+
+    void queryUrbanRuralHistory()
+    {
+        recordHistory("queryUrbanRuralHistory");
+    }
+
+    void listUrbanRuralByRegion()
+    {
+        listByRegion("listUrbanRuralByRegion");
+    }
+};
 
 //城乡规划部
 DEFINE_METHOD(UrbanRuralDemo, UrbanRuralInitialize) { self.UrbanRuralInitialize(); }
 DEFINE_METHOD(UrbanRuralDemo, addUrbanRural) { self.addUrbanRural(); }
 DEFINE_METHOD(UrbanRuralDemo, queryUrbanRural) { self.queryUrbanRural(); }
-DEFINE_METHOD(UrbanRuralDemo, UrbanRuralQueryOwner) { self.UrbanRuralQueryOwner(); }
\ No newline at end of file
+DEFINE_METHOD(UrbanRuralDemo, UrbanRuralQueryOwner) { self.UrbanRuralQueryOwner(); }
+DEFINE_METHOD(UrbanRuralDemo, addUrbanRuralBatch) { self.addUrbanRuralBatch(); }
+DEFINE_METHOD(UrbanRuralDemo, queryUrbanRuralBatch) { self.queryUrbanRuralBatch(); }
+DEFINE_METHOD(UrbanRuralDemo, listUrbanRural) { self.listUrbanRural(); }
+DEFINE_METHOD(UrbanRuralDemo, updateUrbanRural) { self.updateUrbanRural(); }
+DEFINE_METHOD(UrbanRuralDemo, queryStats) { self.queryStats(); }
+DEFINE_METHOD(UrbanRuralDemo, UrbanRuralChangesSince) { self.UrbanRuralChangesSince(); }
+DEFINE_METHOD(UrbanRuralDemo, queryUrbanRuralProof) { self.queryUrbanRuralProof(); }
+DEFINE_METHOD(UrbanRuralDemo, existsUrbanRural) { self.existsUrbanRural(); }
+DEFINE_METHOD(UrbanRuralDemo, existsUrbanRuralBatch) { self.existsUrbanRuralBatch(); }
+DEFINE_METHOD(UrbanRuralDemo, reindexUrbanRural) { self.reindexUrbanRural(); }
+DEFINE_METHOD(UrbanRuralDemo, queryUrbanRuralAt) { self.queryUrbanRuralAt(); }
+DEFINE_METHOD(UrbanRuralDemo, queryUrbanRuralHistory) { self.queryUrbanRuralHistory(); }
+DEFINE_METHOD(UrbanRuralDemo, listUrbanRuralByRegion) { self.listUrbanRuralByRegion(); }
\ No newline at end of file
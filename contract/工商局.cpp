@@ -1,137 +1,7 @@
 #include "xchain/xchain.h"
 
-// 学生成绩上链存证API规范
-// 参数由Context提供
-class ScoreRecord {
-public:
-    // 初始化写入权限
-    // 参数: owner - 具有写入权限的address
-    virtual void initialize() = 0;
-
-    // 写入课程成绩
-    // 参数: userid - 学生的主键id
-    //      data - 学生的成绩信息(json格式string)
-    virtual void addScore() = 0;
-
-    // 按照学生id查询成绩
-    // 参数: userid - 学生的主键id
-    // 返回值: data - 学生的成绩信息(json格式string)
-    virtual void queryScore() = 0;
-
-    // 查询具有写权限的账户
-    // 返回值: 具有写权限的address
-    virtual void queryOwner() = 0;
-};
-
-struct ScoreRecordDemo : public ScoreRecord, public xchain::Contract {
-private:
-    // define the key prefix of buckets
-    const std::string OWNER_KEY = "Owner";
-    const std::string RECORD_KEY = "R_";
-
-    // check if caller is the owner of this contract
-    bool isOwner(xchain::Context* ctx, const std::string& caller) {
-        std::string owner;
-        if (!ctx->get_object(OWNER_KEY, &owner)) {
-            return false;
-        }
-        return (owner == caller);
-    }
-
-public:
-    void initialize() {
-        // 获取合约上下文对象
-        xchain::Context* ctx = this->context();
-        // 从合约上下文中获取合约参数, 由合约部署者指定具有写入权限的address
-        std::string owner = ctx->arg("owner");
-        if (owner.empty()) {
-            ctx->error("missing owner address");
-            return;
-        }
-        // 将具有写入权限的owner地址记录在区块链账本中
-        ctx->put_object(OWNER_KEY, owner);
-        ctx->ok("success");
-    }
-
-    void addScore() {
-        // 获取合约上下文对象
-        xchain::Context* ctx = this->context();
-        // 获取发起者身份
-        const std::string& caller = ctx->initiator();
-        if (caller.empty()) {
-            ctx->error("missing initiator");
-            return;
-        }
-        // 如果写操作发起者不是具有写权限的用户，则无权写入
-        if (!isOwner(ctx, caller)) {
-            ctx->error(
-                "permission check failed, only the owner can add score record");
-            return;
-        }
-
-        // 从参数中获取用户主键id，必填参数，没有则返回错误
-        const std::string& userid = ctx->arg("userid");
-        if (userid.empty()) {
-            ctx->error("missing 'userid'");
-            return;
-        }
-        // 从参数中获取成绩数据，必填参数，没有则返回错误
-        const std::string& data = ctx->arg("data");
-        if (data.empty()) {
-            ctx->error("missing 'data'");
-            return;
-        }
-
-        // 将具有写入权限的owner地址记录在区块链账本中
-        std::string score_key = RECORD_KEY + userid;
-        if (!ctx->put_object(score_key, data)) {
-            ctx->error("failed to save score record");
-            return;
-        }
-
-        // 执行成功，返回status code 200
-        ctx->ok(userid);
-    }
-
-    void queryScore() {
-        // 获取合约上下文对象
-        xchain::Context* ctx = this->context();
-
-        // 从参数中获取用户主键id，必填参数，没有则返回错误
-        const std::string& userid = ctx->arg("userid");
-        if (userid.empty()) {
-            ctx->error("missing 'userid'");
-            return;
-        }
-
-        // 从账本中读取学生的成绩数据
-        std::string score_key = RECORD_KEY + userid;
-        std::string data;
-        if (!ctx->get_object(score_key, &data)) {
-            // 没查到，说明之前没上链过，返回错误
-            ctx->error("no score record found of " + userid);
-            return;
-        }
-
-        // 执行成功，返回status code 200
-        ctx->ok(data);
-    }
-
-    void queryOwner() {
-        // 获取合约上下文对象
-        xchain::Context* ctx = this->context();
-        std::string owner;
-        if (!ctx->get_object(OWNER_KEY, &owner)) {
-            // 没查到owner信息，可能
-            ctx->error("get owner failed");
-            return;
-        }
-        // 执行成功，返回owner address
-        ctx->ok(owner);
-    }
-};
-
-#include "xchain/xchain.h"
+#include "agency_schemas.h"
+#include "record_contract.h"
 
 // 工商局存证上链存证API规范
 // 参数由Context提供
@@ -150,201 +20,243 @@ public:
 
     // 按照身份证查询营业执照
     // 参数: userid：身份证,name：名称,address：地址,charger：负责人,businessScope：经营范围,operatingPeriod：经营日期
+    // 可选参数: fields - 逗号分隔的字段名, 只返回这些字段(userid总是返回)
     // 返回值: data - 营业执照的信息(json格式string)
     virtual void queryBusiness() = 0;
 
     // 查询具有写权限的账户
     // 返回值: 具有写权限的address
     virtual void businessQueryOwner() = 0;
-};
 
-class BusinessData
-{
-public:
-    std::string name;
-    std::string address;
-    std::string charger;
-    std::string businessScope;
-    std::string operatingPeriod;
+    // 批量写入营业执照
+    // 参数: records - 记录数组(json格式string), 每个元素包含userid及全部字段
+    // 返回值: 每条记录的写入结果(json格式string), 单条不合法不影响其余记录
+    virtual void addBusinessBatch() = 0;
+
+    // 批量查询营业执照
+    // 参数: userids - 主键数组(json格式string)
+    // 可选参数: fields - 逗号分隔的字段名, 只返回这些字段(userid总是返回)
+    // 返回值: records - 查到的记录数组, missing - 未查到的主键数组(json格式string)
+    virtual void queryBusinessBatch() = 0;
+
+    // 按名称查询营业执照
+    // 参数: name - 名称
+    // 可选参数: fields - 逗号分隔的字段名, 只返回这些字段(userid总是返回)
+    // 返回值: records - 名称相同的全部营业执照, partial - 补齐前的旧记录可能未计入时为true(json格式string)
+    virtual void queryBusinessByName() = 0;
+
+    // 按负责人查询营业执照
+    // 参数: charger - 负责人
+    // 可选参数: fields - 逗号分隔的字段名, 只返回这些字段(userid总是返回)
+    // 返回值: records - 该负责人名下的全部营业执照, partial - 补齐前的旧记录可能未计入时为true(json格式string)
+    virtual void queryBusinessByCharger() = 0;
+
+    // 分页列举营业执照
+    // 参数: limit - 每页条数(默认20, 最大100), cursor - 上一页返回的游标, keysOnly - 为true时只返回主键
+    // 可选参数: fields - 逗号分隔的字段名, 只返回这些字段(userid总是返回)
+    // 返回值: records/userids - 本页数据, cursor - 存在下一页时返回(json格式string)
+    virtual void listBusiness() = 0;
+
+    // 部分更新营业执照, 只需传入要修改的字段
+    // 参数: userid - 主键id（身份证）, 其余为要修改的字段, 未传入的字段保持不变
+    // 返回值: userid及更新后的记录版本号version(json格式string)
+    virtual void updateBusiness() = 0;
+
+    // 查询各方法累计的资源消耗, 只累计带了参数 stats=true 并写了账本的调用
+    // 返回值: stats - 每个方法的调用次数calls、账本读写次数reads/writes、读写字节数bytesRead/bytesWritten、遍历步数iteratorSteps(json格式string)
+    virtual void queryStats() = 0;
+
+    // 按序号增量同步营业执照的变更
+    // 参数: seq - 上次同步到的序号(缺省为0), limit - 每页条数(默认20, 最大100)
+    // 返回值: changes - seq之后按序号排列的变更(seq、userid、version), seq - 本页最后的序号, more - 还有后续时为true(json格式string)
+    virtual void businessChangesSince() = 0;
+
+    // 查询营业执照的 Merkle 包含证明, 第三方可据此单独验证一条记录
+    // 参数: userid - 主键id（身份证）
+    // 返回值: index - 叶子编号, leaves - 叶子总数, leaf/root - 叶子和根哈希, siblings - 自下而上的兄弟节点哈希(json格式string)
+    // 验证: 叶子为 sha256(0x00 || 查询该记录返回的json), 依次与兄弟节点按 sha256(0x01 || 左 || 右) 合并, 结果应等于 root
+    virtual void queryBusinessProof() = 0;
+
+    // 查询营业执照是否存在, 不读取记录内容
+    // 参数: userid - 主键id（身份证）
+    // 返回值: userid及是否存在exists(json格式string)
+    virtual void existsBusiness() = 0;
+
+    // 批量查询营业执照是否存在
+    // 参数: userids - 主键数组(json格式string)
+    // 返回值: found - 存在的主键数组, missing - 不存在的主键数组(json格式string)
+    virtual void existsBusinessBatch() = 0;
+
+    // 为升级前写入的营业执照补齐二级索引、存在性过滤器、Merkle 树、分组汇总、到期索引、区划索引和关键词索引, 需分页调用到没有cursor返回为止
+    // 参数: limit - 每页条数(默认20, 最大100), cursor - 上一页返回的游标
+    // 返回值: reindexed - 本页处理的条数, cursor - 存在下一页时返回(json格式string)
+    virtual void reindexBusiness() = 0;
+
+    // 按经营范围汇总营业执照, 只读取固定数量的汇总分块, 不遍历记录
+    // 参数: businessScope - 经营范围
+    // 返回值: businessScope, count - 记录数; 补齐前的旧记录未计入时带 partial(json格式string)
+    virtual void queryBusinessAggregate() = 0;
+
+    // 查询营业执照的某个历史版本
+    // 参数: userid - 主键id（身份证）, version - 版本号, fields - 逗号分隔的字段名(可选, 缺省返回全部字段)
+    // 返回值: 该版本的营业执照, 格式与查询当前版本相同(json格式string)
+    virtual void queryBusinessAt() = 0;
+
+    // 查询营业执照的修订历史, 从新到旧排列
+    // 参数: userid - 主键id（身份证）, limit - 条数(默认20, 最大100), before - 只返回小于该版本号的修订(可选)
+    // 返回值: revisions - 各修订的版本号version、变更序号seq和当时的记录record, more - 还有更早的修订时为true(json格式string)
+    virtual void queryBusinessHistory() = 0;
+
+    // 列出到期日在给定区间内的营业执照, 到期日取经营期限 operatingPeriod中的最后一个日期
+    // 参数: from/to - 起止日期(YYYY-MM-DD, 含两端), limit - 每页条数(默认20, 最大100), cursor - 上一页返回的游标
+    // 返回值: expiring - 按到期日排列的userid和到期日expiry, cursor - 存在下一页时返回, partial - 补齐前的旧记录未计入时为true(json格式string)
+    virtual void businessExpiringBetween() = 0;
+
+    // 按行政区划列出营业执照, 区划由地址 address开头的 省/市/区县/街道乡镇 逐级解析
+    // 参数: code - 区划路径, 如 北京市/海淀区, 可到任一级为止; limit - 每页条数(默认20, 最大100), cursor - 上一页返回的游标
+    // 返回值: records - 按区划排列的userid和区划路径region, cursor - 存在下一页时返回, partial - 补齐前的旧记录未计入时为true(json格式string)
+    virtual void listBusinessByRegion() = 0;
+
+    // 按关键词检索营业执照的名称和经营范围, 每个关键词至少两个字, 记录须包含全部关键词
+    // 参数: keywords - 以空格分隔的关键词, limit - 每页条数(默认20, 最大100), cursor - 上一页返回的游标
+    // 返回值: records - 匹配的营业执照(只含名称和经营范围), cursor - 可能还有下一页时返回, partial - 补齐前的旧记录未计入时为true(json格式string)
+    virtual void searchBusiness() = 0;
 };
-class BusinessVar
-{
-public:
-    std::string name = "name";
-    std::string address = "address";
-    std::string charger = "charger";
-    std::string businessScope = "businessScope";
-    std::string operatingPeriod = "operatingPeriod";
-    std::string userid = "userid";
 
-};
-struct BusinessDemo : public Business, public xchain::Contract
+struct BusinessDemo : public Business, public RecordContract<BusinessSchema>
 {
-private:
-    // define the key prefix of buckets
-    const std::string OWNER_KEY = "Owner";
-    const std::string RECORD_KEY = "R_";
-    std::string userid;
-
-    std::string score_key;
-    // check if caller is the owner of this contract
-    bool isOwner(xchain::Context *ctx, const std::string &caller)
-    {
-        std::string owner;
-        if (!ctx->get_object(OWNER_KEY, &owner))
-        {
-            return false;
-        }
-        return (owner == caller);
-    }
-
 public:
     void businessInitialize()
     {
-        // 获取合约上下文对象
-        xchain::Context *ctx = this->context();
-        // 从合约上下文中获取合约参数, 由合约部署者指定具有写入权限的address
-        std::string owner = ctx->arg("owner");
-        if (owner.empty())
-        {
-            ctx->error("missing owner address");
-            return;
-        }
-        // 将具有写入权限的owner地址记录在区块链账本中
-        ctx->put_object(OWNER_KEY, owner);
-        ctx->ok("success");
+        initializeOwner("businessInitialize");
     }
 
     void addBusiness()
     {
-        BusinessData businessData;
-        BusinessVar businessVar;
-        // 获取合约上下文对象
-        xchain::Context *ctx = this->context();
-        // 获取发起者身份
-        const std::string &caller = ctx->initiator();
-        if (caller.empty())
-        {
-            ctx->error("missing initiator");
-            return;
-        }
-        // 如果写操作发起者不是具有写权限的用户，则无权写入
-        if (!isOwner(ctx, caller))
-        {
-            ctx->error(
-                "permission check failed, only the owner can add score record");
-            return;
-        }
-
-        // 从参数中获取营业执照的主键，必填参数，没有则返回错误
-        const std::string &userid = ctx->arg("userid");
-        if (userid.empty())
-        {
-            ctx->error("missing 'userid'");
-            return;
-        }
-        // 从参数中获取姓名，必填参数，没有则返回错误
-        businessData.name = ctx->arg("name");
-        if (businessData.name.empty())
-        {
-            ctx->error("missing 'name'");
-            return;
-        }
-        // 从参数中获取地址，必填参数，没有则返回错误
-        businessData.address = ctx->arg("address");
-        if (businessData.address.empty())
-        {
-            ctx->error("missing 'address'");
-            return;
-        }
-        // 从参数中获取负责人数据，必填参数，没有则返回错误
-        businessData.charger = ctx->arg("charger");
-        if (businessData.charger.empty())
-        {
-            ctx->error("missing 'charger'");
-            return;
-        }
-        // 从参数中获取经营范围，必填参数，没有则返回错误
-        businessData.businessScope = ctx->arg("businessScope");
-        if (businessData.businessScope.empty())
-        {
-            ctx->error("missing 'businessScope'");
-            return;
-        }
-        // 从参数中获取经营时间，必填参数，没有则返回错误
-        businessData.operatingPeriod = ctx->arg("operatingPeriod");
-        if (businessData.operatingPeriod.empty())
-        {
-            ctx->error("missing 'operatingPeriod'");
-            return;
-        }
-
-        // 将具有写入权限的owner地址记录在区块链账本中
-        std::string score_key = RECORD_KEY + userid;
-
-        std::string res = "{\"" + businessVar.name + "\":\"" + businessData.name + "\"," + "\"" + businessVar.address + "\":\"" + businessData.address + "\"," + "\"" +
-                          businessVar.charger + "\":\"" + businessData.charger + "\"," + "\"" + businessVar.businessScope + "\":\"" + businessData.businessScope + "\"," + "\"" + businessVar.operatingPeriod + "\":\"" + businessData.operatingPeriod + "\","+"\"" + businessVar.userid + "\":\"" + userid + "\"}";
-        if (!ctx->put_object(score_key, res))
-        {
-            ctx->error("failed to save score record");
-            return;
-        }
-
-        // 执行成功，返回status code 200
-        ctx->ok(userid);
+        addRecord("addBusiness");
     }
 
     void queryBusiness()
     {
-        // 获取合约上下文对象
-        xchain::Context *ctx = this->context();
-        BusinessData businessData1;
-        BusinessVar businessVar1;
-        // 从参数中获取用户主键id，必填参数，没有则返回错误
-        const std::string &userid = ctx->arg("userid");
-        if (userid.empty())
-        {
-            ctx->error("missing 'userid'");
-            return;
-        }
-
-        // 从账本中读取营业执照数据
-        std::string score_key = RECORD_KEY + userid;
-        std::string data;
-        if (!ctx->get_object(score_key, &data))
-        {
-            // 没查到，说明之前没上链过，返回错误
-            ctx->error("no name record found of " + userid);
-            return;
-        }
-
-        ctx->ok(data);
+        queryRecord("queryBusiness");
     }
 
     void businessQueryOwner()
     {
-        // 获取合约上下文对象
-        xchain::Context *ctx = this->context();
-        std::string owner;
-        if (!ctx->get_object(OWNER_KEY, &owner))
-        {
-            // 没查到owner信息，可能
-            ctx->error("get owner failed");
-            return;
-        }
-        // 执行成功，返回owner address
-        ctx->ok(owner);
+        queryOwner("businessQueryOwner");
+    }
+
+    void addBusinessBatch()
+    {
+        addRecordBatch("addBusinessBatch");
+    }
+
+    void queryBusinessBatch()
+    {
+        queryRecordBatch("queryBusinessBatch");
+    }
+
+    void queryBusinessByName()
+    {
+        queryRecordBy("queryBusinessByName", "name");
     }
-};
 
-//学生
-DEFINE_METHOD(ScoreRecordDemo, initialize) { self.initialize(); }
-DEFINE_METHOD(ScoreRecordDemo, addScore) { self.addScore(); }
-DEFINE_METHOD(ScoreRecordDemo, queryScore) { self.queryScore(); }
-DEFINE_METHOD(ScoreRecordDemo, queryOwner) { self.queryOwner(); }
+    void queryBusinessByCharger()
+    {
+        queryRecordBy("queryBusinessByCharger", "charger");
+    }
+
+    void listBusiness()
+    {
+        listRecords("listBusiness");
+    }
+
+    void updateBusiness()
+    {
+        updateRecord("updateBusiness");
+    }
+
+    void queryStats()
+    {
+        queryCallStats();
+    }
+
+    void businessChangesSince()
+    {
+        changesSince("businessChangesSince");
+    }
+
+    void queryBusinessProof()
+    {
+        proveRecord("queryBusinessProof");
+    }
+
+    void existsBusiness()
+    {
+        existsRecord("existsBusiness");
+    }
+
+    void existsBusinessBatch()
+    {
+        existsRecordBatch("existsBusinessBatch");
+    }
+
+    void reindexBusiness()
+    {
+        reindexRecords("reindexBusiness");
+    }
+
+    void queryBusinessAggregate()
+    {
+        queryAggregate("queryBusinessAggregate", "businessScope");
+    }
+
+    void queryBusinessAt()
+    {
+        queryRecordAt("queryBusinessAt");
+    }
+
+    void queryBusinessHistory()
+    {
+        recordHistory("queryBusinessHistory");
+    }
+
+    void businessExpiringBetween()
+    {
+        expiringBetween("businessExpiringBetween");
+    }
+
+    void listBusinessByRegion()
+    {
+        listByRegion("listBusinessByRegion");
+    }
+
+    void searchBusiness()
+    {
+        searchRecords("searchBusiness");
+    }
+};
 
 //工商局
 DEFINE_METHOD(BusinessDemo, businessInitialize) { self.businessInitialize(); }
 DEFINE_METHOD(BusinessDemo, addBusiness) { self.addBusiness(); }
 DEFINE_METHOD(BusinessDemo, queryBusiness) { self.queryBusiness(); }
 DEFINE_METHOD(BusinessDemo, businessQueryOwner) { self.businessQueryOwner(); }
+DEFINE_METHOD(BusinessDemo, addBusinessBatch) { self.addBusinessBatch(); }
+DEFINE_METHOD(BusinessDemo, queryBusinessBatch) { self.queryBusinessBatch(); }
+DEFINE_METHOD(BusinessDemo, queryBusinessByName) { self.queryBusinessByName(); }
+DEFINE_METHOD(BusinessDemo, queryBusinessByCharger) { self.queryBusinessByCharger(); }
+DEFINE_METHOD(BusinessDemo, listBusiness) { self.listBusiness(); }
+DEFINE_METHOD(BusinessDemo, updateBusiness) { self.updateBusiness(); }
+DEFINE_METHOD(BusinessDemo, queryStats) { self.queryStats(); }
+DEFINE_METHOD(BusinessDemo, businessChangesSince) { self.businessChangesSince(); }
+DEFINE_METHOD(BusinessDemo, queryBusinessProof) { self.queryBusinessProof(); }
+DEFINE_METHOD(BusinessDemo, existsBusiness) { self.existsBusiness(); }
+DEFINE_METHOD(BusinessDemo, existsBusinessBatch) { self.existsBusinessBatch(); }
+DEFINE_METHOD(BusinessDemo, reindexBusiness) { self.reindexBusiness(); }
+DEFINE_METHOD(BusinessDemo, queryBusinessAggregate) { self.queryBusinessAggregate(); }
+DEFINE_METHOD(BusinessDemo, queryBusinessAt) { self.queryBusinessAt(); }
+DEFINE_METHOD(BusinessDemo, queryBusinessHistory) { self.queryBusinessHistory(); }
+DEFINE_METHOD(BusinessDemo, businessExpiringBetween) { self.businessExpiringBetween(); }
+DEFINE_METHOD(BusinessDemo, listBusinessByRegion) { self.listBusinessByRegion(); }
+DEFINE_METHOD(BusinessDemo, searchBusiness) { self.searchBusiness(); }
@@ -1,137 +1,7 @@
 #include "xchain/xchain.h"
 
-
-// 学生成绩上链存证API规范
-// 参数由Context提供
-class ScoreRecord {
-public:
-    // 初始化写入权限
-    // 参数: owner - 具有写入权限的address
-    virtual void initialize() = 0;
-
-    // 写入课程成绩
-    // 参数: userid - 学生的主键id
-    //      data - 学生的成绩信息(json格式string)
-    virtual void addScore() = 0;
-
-    // 按照学生id查询成绩
-    // 参数: userid - 学生的主键id
-    // 返回值: data - 学生的成绩信息(json格式string)
-    virtual void queryScore() = 0;
-
-    // 查询具有写权限的账户
-    // 返回值: 具有写权限的address
-    virtual void queryOwner() = 0;
-};
-
-struct ScoreRecordDemo : public ScoreRecord, public xchain::Contract {
-private:
-    // define the key prefix of buckets
-    const std::string OWNER_KEY = "Owner";
-    const std::string RECORD_KEY = "R_";
-
-    // check if caller is the owner of this contract
-    bool isOwner(xchain::Context* ctx, const std::string& caller) {
-        std::string owner;
-        if (!ctx->get_object(OWNER_KEY, &owner)) {
-            return false;
-        }
-        return (owner == caller);
-    }
-
-public:
-    void initialize() {
-        // 获取合约上下文对象
-        xchain::Context* ctx = this->context();
-        // 从合约上下文中获取合约参数, 由合约部署者指定具有写入权限的address
-        std::string owner = ctx->arg("owner");
-        if (owner.empty()) {
-            ctx->error("missing owner address");
-            return;
-        }
-        // 将具有写入权限的owner地址记录在区块链账本中
-        ctx->put_object(OWNER_KEY, owner);
-        ctx->ok("success");
-    }
-
-    void addScore() {
-        // 获取合约上下文对象
-        xchain::Context* ctx = this->context();
-        // 获取发起者身份
-        const std::string& caller = ctx->initiator();
-        if (caller.empty()) {
-            ctx->error("missing initiator");
-            return;
-        }
-        // 如果写操作发起者不是具有写权限的用户，则无权写入
-        if (!isOwner(ctx, caller)) {
-            ctx->error(
-                "permission check failed, only the owner can add score record");
-            return;
-        }
-
-        // 从参数中获取用户主键id，必填参数，没有则返回错误
-        const std::string& userid = ctx->arg("userid");
-        if (userid.empty()) {
-            ctx->error("missing 'userid'");
-            return;
-        }
-        // 从参数中获取成绩数据，必填参数，没有则返回错误
-        const std::string& data = ctx->arg("data");
-        if (data.empty()) {
-            ctx->error("missing 'data'");
-            return;
-        }
-
-        // 将具有写入权限的owner地址记录在区块链账本中
-        std::string score_key = RECORD_KEY + userid;
-        if (!ctx->put_object(score_key, data)) {
-            ctx->error("failed to save score record");
-            return;
-        }
-
-        // 执行成功，返回status code 200
-        ctx->ok(userid);
-    }
-
-    void queryScore() {
-        // 获取合约上下文对象
-        xchain::Context* ctx = this->context();
-
-        // 从参数中获取用户主键id，必填参数，没有则返回错误
-        const std::string& userid = ctx->arg("userid");
-        if (userid.empty()) {
-            ctx->error("missing 'userid'");
-            return;
-        }
-
-     
-        std::string score_key = RECORD_KEY + userid;
-        std::string data;
-        if (!ctx->get_object(score_key, &data)) {
-            // 没查到，说明之前没上链过，返回错误
-            ctx->error("no score record found of " + userid);
-            return;
-        }
-
-        // 执行成功，返回status code 200
-        ctx->ok(data);
-    }
-
-    void queryOwner() {
-        // 获取合约上下文对象
-        xchain::Context* ctx = this->context();
-        std::string owner;
-        if (!ctx->get_object(OWNER_KEY, &owner)) {
-            // 没查到owner信息，可能
-            ctx->error("get owner failed");
-            return;
-        }
-        // 执行成功，返回owner address
-        ctx->ok(owner);
-    }
-};
-
+#include "agency_schemas.h"
+#include "record_contract.h"
 
 //房管局
 class HousingAuthority
@@ -148,203 +18,198 @@ public:
 
     // 按照主键id查询成绩
     // 参数: userid - 主键id（身份证）
+    // 可选参数: fields - 逗号分隔的字段名, 只返回这些字段(userid总是返回)
     // 返回值: data - 预售房许可证信息(json格式string)
     virtual void queryHousingAuthority() = 0;
 
     // 查询具有写权限的账户
     // 返回值: 具有写权限的preArea
     virtual void HousingAuthorityQueryOwner() = 0;
-};
 
-class HousingAuthorityData
-{
-public:
-    std::string preSeller;//预售人
-    std::string preArea;//预售面积
-    std::string projectName;//项目名称
-    std::string usualSaleNum;//常房售号
-    std::string issueDate;//签发日期
-};
-class HousingAuthorityVar
-{
-public:
-    std::string preSeller = "preSeller";
-    std::string preArea = "preArea";
-    std::string projectName = "projectName";
-    std::string usualSaleNum = "usualSaleNum";
-    std::string issueDate = "issueDate";
-    std::string userid = "userid";
+    // 批量写入预售房许可证
+    // 参数: records - 记录数组(json格式string), 每个元素包含userid及全部字段
+    // 返回值: 每条记录的写入结果(json格式string), 单条不合法不影响其余记录
+    virtual void addHousingAuthorityBatch() = 0;
+
+    // 批量查询预售房许可证
+    // 参数: userids - 主键数组(json格式string)
+    // 可选参数: fields - 逗号分隔的字段名, 只返回这些字段(userid总是返回)
+    // 返回值: records - 查到的记录数组, missing - 未查到的主键数组(json格式string)
+    virtual void queryHousingAuthorityBatch() = 0;
+
+    // 按项目名称查询预售房许可证
+    // 参数: projectName - 项目名称
+    // 可选参数: fields - 逗号分隔的字段名, 只返回这些字段(userid总是返回)
+    // 返回值: records - 该项目的全部预售房许可证, partial - 补齐前的旧记录可能未计入时为true(json格式string)
+    virtual void queryHousingAuthorityByProjectName() = 0;
+
+    // 分页列举预售房许可证
+    // 参数: limit - 每页条数(默认20, 最大100), cursor - 上一页返回的游标, keysOnly - 为true时只返回主键
+    // 可选参数: fields - 逗号分隔的字段名, 只返回这些字段(userid总是返回)
+    // 返回值: records/userids - 本页数据, cursor - 存在下一页时返回(json格式string)
+    virtual void listHousingAuthority() = 0;
+
+    // 部分更新预售房许可证, 只需传入要修改的字段
+    // 参数: userid - 主键id（身份证）, 其余为要修改的字段, 未传入的字段保持不变
+    // 返回值: userid及更新后的记录版本号version(json格式string)
+    virtual void updateHousingAuthority() = 0;
+
+    // 查询各方法累计的资源消耗, 只累计带了参数 stats=true 并写了账本的调用
+    // 返回值: stats - 每个方法的调用次数calls、账本读写次数reads/writes、读写字节数bytesRead/bytesWritten、遍历步数iteratorSteps(json格式string)
+    virtual void queryStats() = 0;
+
+    // 按序号增量同步预售房许可证的变更
+    // 参数: seq - 上次同步到的序号(缺省为0), limit - 每页条数(默认20, 最大100)
+    // 返回值: changes - seq之后按序号排列的变更(seq、userid、version), seq - 本页最后的序号, more - 还有后续时为true(json格式string)
+    virtual void HousingAuthorityChangesSince() = 0;
+
+    // 查询预售房许可证的 Merkle 包含证明, 第三方可据此单独验证一条记录
+    // 参数: userid - 主键id（身份证）
+    // 返回值: index - 叶子编号, leaves - 叶子总数, leaf/root - 叶子和根哈希, siblings - 自下而上的兄弟节点哈希(json格式string)
+    // 验证: 叶子为 sha256(0x00 || 查询该记录返回的json), 依次与兄弟节点按 sha256(0x01 || 左 || 右) 合并, 结果应等于 root
+    virtual void queryHousingAuthorityProof() = 0;
+
+    // 查询预售房许可证是否存在, 不读取记录内容
+    // 参数: userid - 主键id（身份证）
+    // 返回值: userid及是否存在exists(json格式string)
+    virtual void existsHousingAuthority() = 0;
+
+    // 批量查询预售房许可证是否存在
+    // 参数: userids - 主键数组(json格式string)
+    // 返回值: found - 存在的主键数组, missing - 不存在的主键数组(json格式string)
+    virtual void existsHousingAuthorityBatch() = 0;
+
+    // 为升级前写入的预售房许可证补齐二级索引、存在性过滤器、Merkle 树和分组汇总, 需分页调用到没有cursor返回为止
+    // 参数: limit - 每页条数(默认20, 最大100), cursor - 上一页返回的游标
+    // 返回值: reindexed - 本页处理的条数, cursor - 存在下一页时返回(json格式string)
+    virtual void reindexHousingAuthority() = 0;
+
+    // 按项目名称汇总预售房许可证, 只读取固定数量的汇总分块, 不遍历记录
+    // 参数: projectName - 项目名称
+    // 返回值: projectName, count - 记录数, preArea - 预售面积合计; 补齐前的旧记录未计入时带 partial(json格式string)
+    virtual void queryHousingAuthorityAggregate() = 0;
+
+    // 查询预售房许可证的某个历史版本
+    // 参数: userid - 主键id（身份证）, version - 版本号, fields - 逗号分隔的字段名(可选, 缺省返回全部字段)
+    // 返回值: 该版本的预售房许可证, 格式与查询当前版本相同(json格式string)
+    virtual void queryHousingAuthorityAt() = 0;
+
+    // 查询预售房许可证的修订历史, 从新到旧排列
+    // 参数: userid - 主键id（身份证）, limit - 条数(默认20, 最大100), before - 只返回小于该版本号的修订(可选)
+    // 返回值: revisions - 各修订的版本号version、变更序号seq和当时的记录record, more - 还有更早的修订时为true(json格式string)
+    virtual void queryHousingAuthorityHistory() = 0;
 };
-struct HousingAuthorityDemo : public HousingAuthority, public xchain::Contract
-{
-private:
-    // define the key prefix of buckets
-    const std::string OWNER_KEY = "Owner";
-    const std::string RECORD_KEY = "R_";
-    std::string userid;
-
-    std::string score_key;
-    // check if caller is the owner of this contract
-    bool isOwner(xchain::Context *ctx, const std::string &caller)
-    {
-        std::string owner;
-        if (!ctx->get_object(OWNER_KEY, &owner))
-        {
-            return false;
-        }
-        return (owner == caller);
-    }
 
+struct HousingAuthorityDemo : public HousingAuthority, public RecordContract<HousingAuthoritySchema>
+{
 public:
     void HousingAuthorityInitialize()
     {
-        // 获取合约上下文对象
-        xchain::Context *ctx = this->context();
-        // 从合约上下文中获取合约参数, 由合约部署者指定具有写入权限的preArea
-        std::string owner = ctx->arg("owner");
-        if (owner.empty())
-        {
-            ctx->error("missing owner preArea");
-            return;
-        }
-        // 将具有写入权限的owner地址记录在区块链账本中
-        ctx->put_object(OWNER_KEY, owner);
-        ctx->ok("success");
+        initializeOwner("HousingAuthorityInitialize");
     }
 
     void addHousingAuthority()
     {
-        HousingAuthorityData HousingAuthorityData;
-        HousingAuthorityVar HousingAuthorityVar;
-        // 获取合约上下文对象
-        xchain::Context *ctx = this->context();
-        // 获取发起者身份
-        const std::string &caller = ctx->initiator();
-        if (caller.empty())
-        {
-            ctx->error("missing initiator");
-            return;
-        }
-        // 如果写操作发起者不是具有写权限的用户，则无权写入
-        if (!isOwner(ctx, caller))
-        {
-            ctx->error(
-                "permission check failed, only the owner can add score record");
-            return;
-        }
-
-        // 从参数中获取用户主键id，必填参数，没有则返回错误
-        const std::string &userid = ctx->arg("userid");
-        if (userid.empty())
-        {
-            ctx->error("missing 'userid'");
-            return;
-        }
-        // 从参数中获取预售人，必填参数，没有则返回错误
-        HousingAuthorityData.preSeller = ctx->arg("preSeller");
-        if (HousingAuthorityData.preSeller.empty())
-        {
-            ctx->error("missing 'preSeller'");
-            return;
-        }
-        // 从参数中获取预售面积，必填参数，没有则返回错误
-        HousingAuthorityData.preArea = ctx->arg("preArea");
-        if (HousingAuthorityData.preArea.empty())
-        {
-            ctx->error("missing 'preArea'");
-            return;
-        }
-        // 从参数中获取项目名称，必填参数，没有则返回错误
-        HousingAuthorityData.projectName = ctx->arg("projectName");
-        if (HousingAuthorityData.projectName.empty())
-        {
-            ctx->error("missing 'projectName'");
-            return;
-        }
-        // 从参数中获取常房售号，必填参数，没有则返回错误
-        HousingAuthorityData.usualSaleNum = ctx->arg("usualSaleNum");
-        if (HousingAuthorityData.usualSaleNum.empty())
-        {
-            ctx->error("missing 'usualSaleNum'");
-            return;
-        }
-        // 从参数中获取签发日期，必填参数，没有则返回错误
-        HousingAuthorityData.issueDate = ctx->arg("issueDate");
-        if (HousingAuthorityData.issueDate.empty())
-        {
-            ctx->error("missing 'issueDate'");
-            return;
-        }
-
-        // 将具有写入权限的owner地址记录在区块链账本中
-        std::string score_key = RECORD_KEY + userid;
-
-        std::string res = "{\"" + HousingAuthorityVar.preSeller + "\":\"" + HousingAuthorityData.preSeller + "\"," + "\"" + HousingAuthorityVar.preArea + "\":\"" + HousingAuthorityData.preArea + "\"," + "\"" + HousingAuthorityVar.projectName + "\":\"" + HousingAuthorityData.projectName + "\"," + "\"" + HousingAuthorityVar.usualSaleNum + "\":\"" + HousingAuthorityData.usualSaleNum + "\"," + "\"" + HousingAuthorityVar.issueDate + "\":\"" + HousingAuthorityData.issueDate + "\","+"\"" + HousingAuthorityVar.userid + "\":\"" + userid + "\"}";
-        /*if (!ctx->put_object(score_key, preSeller， preArea， projectName， usualSaleNum， issueDate)) {
-            ctx->error("failed to save score record");*/
-        if (!ctx->put_object(score_key, res))
-        {
-            ctx->error("failed to save score record");
-            return;
-        }
-
-        // 执行成功，返回status code 200
-        ctx->ok(userid);
+        addRecord("addHousingAuthority");
     }
 
     void queryHousingAuthority()
     {
-        // 获取合约上下文对象
-        xchain::Context *ctx = this->context();
-        HousingAuthorityData HousingAuthorityData1;
-        HousingAuthorityVar HousingAuthorityVar1;
-        // 从参数中获取用户主键id，必填参数，没有则返回错误
-        const std::string &userid = ctx->arg("userid");
-        if (userid.empty())
-        {
-            ctx->error("missing 'userid'");
-            return;
-        }
-
-        // 从账本中读取预售房许可证信息
-        std::string score_key = RECORD_KEY + userid;
-        std::string data;
-        //if (!ctx->get_object(score_key, &preSeller, &preArea, &projectName, &usualSaleNum, &issueDate))
-        if (!ctx->get_object(score_key, &data))
-        {
-            // 没查到，说明之前没上链过，返回错误
-            ctx->error("no preSeller record found of " + userid);
-            return;
-        }
-        ctx->ok(data);
+        queryRecord("queryHousingAuthority");
     }
 
     void HousingAuthorityQueryOwner()
     {
-        // 获取合约上下文对象
-        xchain::Context *ctx = this->context();
-        std::string owner;
-        if (!ctx->get_object(OWNER_KEY, &owner))
-        {
-            // 没查到owner信息，可能
-            ctx->error("get owner failed");
-            return;
-        }
-        // 执行成功，返回owner preArea
-        ctx->ok(owner);
+        queryOwner("HousingAuthorityQueryOwner");
+    }
+
+    void addHousingAuthorityBatch()
+    {
+        addRecordBatch("addHousingAuthorityBatch");
+    }
+
+    void queryHousingAuthorityBatch()
+    {
+        queryRecordBatch("queryHousingAuthorityBatch");
+    }
+
+    void queryHousingAuthorityByProjectName()
+    {
+        queryRecordBy("queryHousingAuthorityByProjectName", "projectName");
+    }
+
+    void listHousingAuthority()
+    {
+        listRecords("listHousingAuthority");
+    }
+
+    void updateHousingAuthority()
+    {
+        updateRecord("updateHousingAuthority");
+    }
+
+    void queryStats()
+    {
+        queryCallStats();
+    }
+
+    void HousingAuthorityChangesSince()
+    {
+        changesSince("HousingAuthorityChangesSince");
     }
-};
 
-//学生
+    void queryHousingAuthorityProof()
+    {
+        proveRecord("queryHousingAuthorityProof");
+    }
+
+    void existsHousingAuthority()
+    {
+        existsRecord("existsHousingAuthority");
+    }
 
-DEFINE_METHOD(ScoreRecordDemo, initialize) { self.initialize(); }
-DEFINE_METHOD(ScoreRecordDemo, addScore) { self.addScore(); }
-DEFINE_METHOD(ScoreRecordDemo, queryScore) { self.queryScore(); }
-DEFINE_METHOD(ScoreRecordDemo,queryOwner) { self.queryOwner(); }
+    void existsHousingAuthorityBatch()
+    {
+        existsRecordBatch("existsHousingAuthorityBatch");
+    }
+
+    void reindexHousingAuthority()
+    {
+        reindexRecords("reindexHousingAuthority");
+    }
 
+    void queryHousingAuthorityAggregate()
+    {
+        queryAggregate("queryHousingAuthorityAggregate", "projectName");
+    }
+
+    void queryHousingAuthorityAt()
+    {
+        queryRecordAt("queryHousingAuthorityAt");
+    }
+
+    void queryHousingAuthorityHistory()
+    {
+        recordHistory("queryHousingAuthorityHistory");
+    }
+};
 
 //房管局
 DEFINE_METHOD(HousingAuthorityDemo, HousingAuthorityInitialize) { self.HousingAuthorityInitialize(); }
 DEFINE_METHOD(HousingAuthorityDemo, addHousingAuthority) { self.addHousingAuthority(); }
 DEFINE_METHOD(HousingAuthorityDemo, queryHousingAuthority) { self.queryHousingAuthority(); }
 DEFINE_METHOD(HousingAuthorityDemo, HousingAuthorityQueryOwner) { self.HousingAuthorityQueryOwner(); }
+DEFINE_METHOD(HousingAuthorityDemo, addHousingAuthorityBatch) { self.addHousingAuthorityBatch(); }
+DEFINE_METHOD(HousingAuthorityDemo, queryHousingAuthorityBatch) { self.queryHousingAuthorityBatch(); }
+DEFINE_METHOD(HousingAuthorityDemo, queryHousingAuthorityByProjectName) { self.queryHousingAuthorityByProjectName(); }
+DEFINE_METHOD(HousingAuthorityDemo, listHousingAuthority) { self.listHousingAuthority(); }
+DEFINE_METHOD(HousingAuthorityDemo, updateHousingAuthority) { self.updateHousingAuthority(); }
+DEFINE_METHOD(HousingAuthorityDemo, queryStats) { self.queryStats(); }
+DEFINE_METHOD(HousingAuthorityDemo, HousingAuthorityChangesSince) { self.HousingAuthorityChangesSince(); }
+DEFINE_METHOD(HousingAuthorityDemo, queryHousingAuthorityProof) { self.queryHousingAuthorityProof(); }
+DEFINE_METHOD(HousingAuthorityDemo, existsHousingAuthority) { self.existsHousingAuthority(); }
+DEFINE_METHOD(HousingAuthorityDemo, existsHousingAuthorityBatch) { self.existsHousingAuthorityBatch(); }
+DEFINE_METHOD(HousingAuthorityDemo, reindexHousingAuthority) { self.reindexHousingAuthority(); }
+DEFINE_METHOD(HousingAuthorityDemo, queryHousingAuthorityAggregate) { self.queryHousingAuthorityAggregate(); }
+DEFINE_METHOD(HousingAuthorityDemo, queryHousingAuthorityAt) { self.queryHousingAuthorityAt(); }
+DEFINE_METHOD(HousingAuthorityDemo, queryHousingAuthorityHistory) { self.queryHousingAuthorityHistory(); }
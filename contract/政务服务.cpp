@@ -0,0 +1,287 @@
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "xchain/xchain.h"
+
+#include "agency_schemas.h"
+#include "record_contract.h"
+
+// 政务服务合约: 五个部门的存证部署在同一个合约中
+// 各部门的方法名、参数和返回值与对应的单部门合约相同, 账本键带有部门前缀互不干扰
+// 部署后先由 initialize 指定管理员, 再由管理员调用各部门的初始化方法分别指定写入权限
+struct GovernmentDemo : public xchain::Contract
+{
+private:
+    const std::string ADMIN_KEY = "Admin";
+
+    // 校验发起者是管理员, 失败时已返回错误
+    bool checkAdmin(xchain::Context *ctx)
+    {
+        const std::string &caller = ctx->initiator();
+        if (caller.empty())
+        {
+            ctx->error("missing initiator");
+            return false;
+        }
+        std::string admin;
+        if (!ctx->get_object(ADMIN_KEY, &admin) || admin != caller)
+        {
+            ctx->error("permission check failed, only the admin can call this method");
+            return false;
+        }
+        return true;
+    }
+
+    // 读出一个部门的记录并累计其输出长度, 返回是否查到; 损坏的记录按未查到处理
+    template <class Schema>
+    static bool fetchPart(RecordStore<Schema> &store, const std::string &userid,
+                          typename RecordStore<Schema>::Record *rec, size_t *size)
+    {
+        if (!store.fetchRecord(userid, rec))
+        {
+            return false;
+        }
+        *size += RecordStore<Schema>::recordJsonSize(userid, *rec) + 24;
+        return true;
+    }
+
+    template <class Schema>
+    static void writePart(JsonWriter *json, RecordStore<Schema> &store, const char *name, const std::string &userid,
+                          const typename RecordStore<Schema>::Record &rec, bool found)
+    {
+        if (!found)
+        {
+            return;
+        }
+        json->key(name);
+        store.writeRecordJson(json, userid, rec);
+    }
+
+    // 统计跨部门方法的账本访问, 各部门的存储也经由它访问账本
+    MeteredContext meter{context()};
+
+public:
+    RecordStore<BusinessSchema> business{&meter, "business/"};
+    RecordStore<PoliceSchema> police{&meter, "police/"};
+    RecordStore<LandSchema> land{&meter, "land/"};
+    RecordStore<UrbanRuralSchema> urbanRural{&meter, "urbanRural/"};
+    RecordStore<HousingAuthoritySchema> housingAuthority{&meter, "housingAuthority/"};
+
+    // 指定管理员; 已有管理员时只能由现任管理员调用, 用于移交
+    // 参数: owner - 管理员address
+    void initialize()
+    {
+        xchain::Context *ctx = this->context();
+        const std::string &owner = ctx->arg("owner");
+        if (owner.empty())
+        {
+            ctx->error("missing owner address");
+            return;
+        }
+        std::string admin;
+        if (ctx->get_object(ADMIN_KEY, &admin) && !checkAdmin(ctx))
+        {
+            return;
+        }
+        ctx->put_object(ADMIN_KEY, owner);
+        ctx->ok("success");
+    }
+
+    // 查询管理员
+    // 返回值: 管理员address
+    void queryAdmin()
+    {
+        xchain::Context *ctx = this->context();
+        std::string admin;
+        if (!ctx->get_object(ADMIN_KEY, &admin))
+        {
+            ctx->error("get admin failed");
+            return;
+        }
+        ctx->ok(admin);
+    }
+
+    // 一次调用查询某人在各部门的全部记录
+    // 参数: userid - 主键id（身份证）
+    // 返回值: {"userid":"..","business":{..},"police":{..},...,"missing":[..]}(json格式string)
+    //        没有记录(或记录损坏)的部门不输出, 部门名列入 missing
+    void queryDossier()
+    {
+        CallMeter callMeter(&meter, "queryDossier");
+        xchain::Context *ctx = this->context();
+        const std::string &userid = ctx->arg("userid");
+        if (userid.empty())
+        {
+            ctx->error("missing 'userid'");
+            return;
+        }
+
+        // 先读出全部记录算出响应长度, 再一次性写入响应缓冲区
+        RecordStore<BusinessSchema>::Record businessRec;
+        RecordStore<PoliceSchema>::Record policeRec;
+        RecordStore<LandSchema>::Record landRec;
+        RecordStore<UrbanRuralSchema>::Record urbanRuralRec;
+        RecordStore<HousingAuthoritySchema>::Record housingAuthorityRec;
+        size_t size = 64 + JsonWriter::fieldSize("userid", userid);
+        bool hasBusiness = fetchPart(business, userid, &businessRec, &size);
+        bool hasPolice = fetchPart(police, userid, &policeRec, &size);
+        bool hasLand = fetchPart(land, userid, &landRec, &size);
+        bool hasUrbanRural = fetchPart(urbanRural, userid, &urbanRuralRec, &size);
+        bool hasHousingAuthority = fetchPart(housingAuthority, userid, &housingAuthorityRec, &size);
+
+        JsonWriter json(size);
+        json.beginObject();
+        json.field("userid", userid);
+        writePart(&json, business, "business", userid, businessRec, hasBusiness);
+        writePart(&json, police, "police", userid, policeRec, hasPolice);
+        writePart(&json, land, "land", userid, landRec, hasLand);
+        writePart(&json, urbanRural, "urbanRural", userid, urbanRuralRec, hasUrbanRural);
+        writePart(&json, housingAuthority, "housingAuthority", userid, housingAuthorityRec, hasHousingAuthority);
+        json.key("missing");
+        json.beginArray();
+        const std::pair<const char *, bool> parts[] = {
+            {"business", hasBusiness},
+            {"police", hasPolice},
+            {"land", hasLand},
+            {"urbanRural", hasUrbanRural},
+            {"housingAuthority", hasHousingAuthority},
+        };
+        for (const auto &part : parts)
+        {
+            if (!part.second)
+            {
+                json.string(part.first);
+            }
+        }
+        json.endArray();
+        json.endObject();
+        ctx->ok(json.finish());
+    }
+
+    // 查询各入口方法累计的资源消耗, 按合约方法名统计, 如 addBusiness、queryBusinessByName
+    // 只累计带了参数 stats=true 并写了账本的调用, 见 CallMeter
+    // 返回值: stats - 每个方法的调用次数calls、账本读写次数reads/writes、读写字节数bytesRead/bytesWritten、遍历步数iteratorSteps(json格式string)
+    void queryStats()
+    {
+        CallMeter::queryStats(this->context());
+    }
+
+    // 由管理员指定某个部门具有写入权限的address
+    // 参数: owner - 该部门具有写入权限的address
+    // method 为该部门初始化方法的合约方法名, 用于资源统计
+    template <class Schema>
+    void initializeAgency(RecordStore<Schema> &store, std::string_view method)
+    {
+        if (!checkAdmin(this->context()))
+        {
+            return;
+        }
+        store.initializeOwner(method);
+    }
+};
+
+DEFINE_METHOD(GovernmentDemo, initialize) { self.initialize(); }
+DEFINE_METHOD(GovernmentDemo, queryAdmin) { self.queryAdmin(); }
+DEFINE_METHOD(GovernmentDemo, queryDossier) { self.queryDossier(); }
+DEFINE_METHOD(GovernmentDemo, queryStats) { self.queryStats(); }
+
+//工商局
+DEFINE_METHOD(GovernmentDemo, businessInitialize) { self.initializeAgency(self.business, "businessInitialize"); }
+DEFINE_METHOD(GovernmentDemo, addBusiness) { self.business.addRecord("addBusiness"); }
+DEFINE_METHOD(GovernmentDemo, queryBusiness) { self.business.queryRecord("queryBusiness"); }
+DEFINE_METHOD(GovernmentDemo, businessQueryOwner) { self.business.queryOwner("businessQueryOwner"); }
+DEFINE_METHOD(GovernmentDemo, addBusinessBatch) { self.business.addRecordBatch("addBusinessBatch"); }
+DEFINE_METHOD(GovernmentDemo, queryBusinessBatch) { self.business.queryRecordBatch("queryBusinessBatch"); }
+DEFINE_METHOD(GovernmentDemo, queryBusinessByName) { self.business.queryRecordBy("queryBusinessByName", "name"); }
+DEFINE_METHOD(GovernmentDemo, queryBusinessByCharger) { self.business.queryRecordBy("queryBusinessByCharger", "charger"); }
+DEFINE_METHOD(GovernmentDemo, listBusiness) { self.business.listRecords("listBusiness"); }
+DEFINE_METHOD(GovernmentDemo, updateBusiness) { self.business.updateRecord("updateBusiness"); }
+DEFINE_METHOD(GovernmentDemo, businessChangesSince) { self.business.changesSince("businessChangesSince"); }
+DEFINE_METHOD(GovernmentDemo, queryBusinessProof) { self.business.proveRecord("queryBusinessProof"); }
+DEFINE_METHOD(GovernmentDemo, existsBusiness) { self.business.existsRecord("existsBusiness"); }
+DEFINE_METHOD(GovernmentDemo, existsBusinessBatch) { self.business.existsRecordBatch("existsBusinessBatch"); }
+DEFINE_METHOD(GovernmentDemo, queryBusinessAt) { self.business.queryRecordAt("queryBusinessAt"); }
+DEFINE_METHOD(GovernmentDemo, queryBusinessHistory) { self.business.recordHistory("queryBusinessHistory"); }
+DEFINE_METHOD(GovernmentDemo, reindexBusiness) { self.business.reindexRecords("reindexBusiness"); }
+DEFINE_METHOD(GovernmentDemo, searchBusiness) { self.business.searchRecords("searchBusiness"); }
+DEFINE_METHOD(GovernmentDemo, listBusinessByRegion) { self.business.listByRegion("listBusinessByRegion"); }
+DEFINE_METHOD(GovernmentDemo, businessExpiringBetween) { self.business.expiringBetween("businessExpiringBetween"); }
+DEFINE_METHOD(GovernmentDemo, queryBusinessAggregate) { self.business.queryAggregate("queryBusinessAggregate", "businessScope"); }
+
+//公安局
+DEFINE_METHOD(GovernmentDemo, PoliceInitialize) { self.initializeAgency(self.police, "PoliceInitialize"); }
+DEFINE_METHOD(GovernmentDemo, addPolice) { self.police.addRecord("addPolice"); }
+DEFINE_METHOD(GovernmentDemo, queryPolice) { self.police.queryRecord("queryPolice"); }
+DEFINE_METHOD(GovernmentDemo, PoliceQueryOwner) { self.police.queryOwner("PoliceQueryOwner"); }
+DEFINE_METHOD(GovernmentDemo, addPoliceBatch) { self.police.addRecordBatch("addPoliceBatch"); }
+DEFINE_METHOD(GovernmentDemo, queryPoliceBatch) { self.police.queryRecordBatch("queryPoliceBatch"); }
+DEFINE_METHOD(GovernmentDemo, listPolice) { self.police.listRecords("listPolice"); }
+DEFINE_METHOD(GovernmentDemo, updatePolice) { self.police.updateRecord("updatePolice"); }
+DEFINE_METHOD(GovernmentDemo, PoliceChangesSince) { self.police.changesSince("PoliceChangesSince"); }
+DEFINE_METHOD(GovernmentDemo, queryPoliceProof) { self.police.proveRecord("queryPoliceProof"); }
+DEFINE_METHOD(GovernmentDemo, existsPolice) { self.police.existsRecord("existsPolice"); }
+DEFINE_METHOD(GovernmentDemo, existsPoliceBatch) { self.police.existsRecordBatch("existsPoliceBatch"); }
+DEFINE_METHOD(GovernmentDemo, queryPoliceAt) { self.police.queryRecordAt("queryPoliceAt"); }
+DEFINE_METHOD(GovernmentDemo, queryPoliceHistory) { self.police.recordHistory("queryPoliceHistory"); }
+DEFINE_METHOD(GovernmentDemo, reindexPolice) { self.police.reindexRecords("reindexPolice"); }
+DEFINE_METHOD(GovernmentDemo, listPoliceByRegion) { self.police.listByRegion("listPoliceByRegion"); }
+DEFINE_METHOD(GovernmentDemo, PoliceExpiringBetween) { self.police.expiringBetween("PoliceExpiringBetween"); }
+
+//国土资源局
+DEFINE_METHOD(GovernmentDemo, LandInitialize) { self.initializeAgency(self.land, "LandInitialize"); }
+DEFINE_METHOD(GovernmentDemo, addLand) { self.land.addRecord("addLand"); }
+DEFINE_METHOD(GovernmentDemo, queryLand) { self.land.queryRecord("queryLand"); }
+DEFINE_METHOD(GovernmentDemo, LandQueryOwner) { self.land.queryOwner("LandQueryOwner"); }
+DEFINE_METHOD(GovernmentDemo, addLandBatch) { self.land.addRecordBatch("addLandBatch"); }
+DEFINE_METHOD(GovernmentDemo, queryLandBatch) { self.land.queryRecordBatch("queryLandBatch"); }
+DEFINE_METHOD(GovernmentDemo, queryLandByLandNumber) { self.land.queryRecordBy("queryLandByLandNumber", "landNumber"); }
+DEFINE_METHOD(GovernmentDemo, listLand) { self.land.listRecords("listLand"); }
+DEFINE_METHOD(GovernmentDemo, updateLand) { self.land.updateRecord("updateLand"); }
+DEFINE_METHOD(GovernmentDemo, LandChangesSince) { self.land.changesSince("LandChangesSince"); }
+DEFINE_METHOD(GovernmentDemo, queryLandProof) { self.land.proveRecord("queryLandProof"); }
+DEFINE_METHOD(GovernmentDemo, existsLand) { self.land.existsRecord("existsLand"); }
+DEFINE_METHOD(GovernmentDemo, existsLandBatch) { self.land.existsRecordBatch("existsLandBatch"); }
+DEFINE_METHOD(GovernmentDemo, queryLandAt) { self.land.queryRecordAt("queryLandAt"); }
+DEFINE_METHOD(GovernmentDemo, queryLandHistory) { self.land.recordHistory("queryLandHistory"); }
+DEFINE_METHOD(GovernmentDemo, reindexLand) { self.land.reindexRecords("reindexLand"); }
+DEFINE_METHOD(GovernmentDemo, listLandByRegion) { self.land.listByRegion("listLandByRegion"); }
+DEFINE_METHOD(GovernmentDemo, LandExpiringBetween) { self.land.expiringBetween("LandExpiringBetween"); }
+DEFINE_METHOD(GovernmentDemo, queryLandAggregate) { self.land.queryAggregate("queryLandAggregate", "purpose"); }
+
+//城乡规划部
+DEFINE_METHOD(GovernmentDemo, UrbanRuralInitialize) { self.initializeAgency(self.urbanRural, "UrbanRuralInitialize"); }
+DEFINE_METHOD(GovernmentDemo, addUrbanRural) { self.urbanRural.addRecord("addUrbanRural"); }
+DEFINE_METHOD(GovernmentDemo, queryUrbanRural) { self.urbanRural.queryRecord("queryUrbanRural"); }
+DEFINE_METHOD(GovernmentDemo, UrbanRuralQueryOwner) { self.urbanRural.queryOwner("UrbanRuralQueryOwner"); }
+DEFINE_METHOD(GovernmentDemo, addUrbanRuralBatch) { self.urbanRural.addRecordBatch("addUrbanRuralBatch"); }
+DEFINE_METHOD(GovernmentDemo, queryUrbanRuralBatch) { self.urbanRural.queryRecordBatch("queryUrbanRuralBatch"); }
+DEFINE_METHOD(GovernmentDemo, listUrbanRural) { self.urbanRural.listRecords("listUrbanRural"); }
+DEFINE_METHOD(GovernmentDemo, updateUrbanRural) { self.urbanRural.updateRecord("updateUrbanRural"); }
+DEFINE_METHOD(GovernmentDemo, UrbanRuralChangesSince) { self.urbanRural.changesSince("UrbanRuralChangesSince"); }
+DEFINE_METHOD(GovernmentDemo, queryUrbanRuralProof) { self.urbanRural.proveRecord("queryUrbanRuralProof"); }
+DEFINE_METHOD(GovernmentDemo, existsUrbanRural) { self.urbanRural.existsRecord("existsUrbanRural"); }
+DEFINE_METHOD(GovernmentDemo, existsUrbanRuralBatch) { self.urbanRural.existsRecordBatch("existsUrbanRuralBatch"); }
+DEFINE_METHOD(GovernmentDemo, queryUrbanRuralAt) { self.urbanRural.queryRecordAt("queryUrbanRuralAt"); }
+DEFINE_METHOD(GovernmentDemo, queryUrbanRuralHistory) { self.urbanRural.recordHistory("queryUrbanRuralHistory"); }
+DEFINE_METHOD(GovernmentDemo, reindexUrbanRural) { self.urbanRural.reindexRecords("reindexUrbanRural"); }
+DEFINE_METHOD(GovernmentDemo, listUrbanRuralByRegion) { self.urbanRural.listByRegion("listUrbanRuralByRegion"); }
+
+//房管局
+DEFINE_METHOD(GovernmentDemo, HousingAuthorityInitialize) { self.initializeAgency(self.housingAuthority, "HousingAuthorityInitialize"); }
+DEFINE_METHOD(GovernmentDemo, addHousingAuthority) { self.housingAuthority.addRecord("addHousingAuthority"); }
+DEFINE_METHOD(GovernmentDemo, queryHousingAuthority) { self.housingAuthority.queryRecord("queryHousingAuthority"); }
+DEFINE_METHOD(GovernmentDemo, HousingAuthorityQueryOwner) { self.housingAuthority.queryOwner("HousingAuthorityQueryOwner"); }
+DEFINE_METHOD(GovernmentDemo, addHousingAuthorityBatch) { self.housingAuthority.addRecordBatch("addHousingAuthorityBatch"); }
+DEFINE_METHOD(GovernmentDemo, queryHousingAuthorityBatch) { self.housingAuthority.queryRecordBatch("queryHousingAuthorityBatch"); }
+DEFINE_METHOD(GovernmentDemo, queryHousingAuthorityByProjectName) { self.housingAuthority.queryRecordBy("queryHousingAuthorityByProjectName", "projectName"); }
+DEFINE_METHOD(GovernmentDemo, listHousingAuthority) { self.housingAuthority.listRecords("listHousingAuthority"); }
+DEFINE_METHOD(GovernmentDemo, updateHousingAuthority) { self.housingAuthority.updateRecord("updateHousingAuthority"); }
+DEFINE_METHOD(GovernmentDemo, HousingAuthorityChangesSince) { self.housingAuthority.changesSince("HousingAuthorityChangesSince"); }
+DEFINE_METHOD(GovernmentDemo, queryHousingAuthorityProof) { self.housingAuthority.proveRecord("queryHousingAuthorityProof"); }
+DEFINE_METHOD(GovernmentDemo, existsHousingAuthority) { self.housingAuthority.existsRecord("existsHousingAuthority"); }
+DEFINE_METHOD(GovernmentDemo, existsHousingAuthorityBatch) { self.housingAuthority.existsRecordBatch("existsHousingAuthorityBatch"); }
+DEFINE_METHOD(GovernmentDemo, queryHousingAuthorityAt) { self.housingAuthority.queryRecordAt("queryHousingAuthorityAt"); }
+DEFINE_METHOD(GovernmentDemo, queryHousingAuthorityHistory) { self.housingAuthority.recordHistory("queryHousingAuthorityHistory"); }
+DEFINE_METHOD(GovernmentDemo, reindexHousingAuthority) { self.housingAuthority.reindexRecords("reindexHousingAuthority"); }
+DEFINE_METHOD(GovernmentDemo, queryHousingAuthorityAggregate) { self.housingAuthority.queryAggregate("queryHousingAuthorityAggregate", "projectName"); }
@@ -0,0 +1,153 @@
+// 离线训练记录压缩字典, 输出 contract/record_dict.h
+// 从样本中选出在多条样本里重复出现的片段, 按 (出现的样本数-1)*长度 取收益最高者拼接,
+// 与已选片段大部分重合的候选不再收录, 收益越高的片段放得越靠后, 压缩时引用距离越短
+//
+// 用法:
+//   g++ -std=c++17 -O2 -o train_dict tools/train_dict.cpp
+//   ./train_dict tools/dict_samples.txt [字典字节数, 默认2048] > contract/record_dict.h
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// 片段最少字符数, 再短的片段引用后不比原文短
+const size_t kMinChars = 2;
+const size_t kMaxChars = 48;
+const size_t kMinBytes = 5;
+
+size_t charLength(unsigned char lead)
+{
+    return lead < 0x80 ? 1 : lead < 0xe0 ? 2 : lead < 0xf0 ? 3 : 4;
+}
+
+// 候选的前半或后半已出现在某个已选片段中
+bool overlaps(const std::string &text, const std::vector<std::string> &chosen)
+{
+    size_t half = 0;
+    while (half < text.size() / 2)
+    {
+        half += charLength(text[half]);
+    }
+    std::string head = text.substr(0, half);
+    std::string tail = text.substr(half);
+    for (const std::string &s : chosen)
+    {
+        if (s.find(head) != std::string::npos || s.find(tail) != std::string::npos)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+struct Candidate
+{
+    std::string text;
+    size_t score;
+};
+
+std::string escape(const std::string &s)
+{
+    std::string out;
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: %s samples.txt [dict bytes]\n", argv[0]);
+        return 1;
+    }
+    size_t budget = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2048;
+    std::ifstream in(argv[1]);
+    if (!in)
+    {
+        std::fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 1;
+    }
+
+    // 统计每个片段出现在多少条样本中
+    std::map<std::string, size_t> frequency;
+    std::string line;
+    size_t samples = 0;
+    while (std::getline(in, line))
+    {
+        if (line.empty())
+        {
+            continue;
+        }
+        samples++;
+        std::set<std::string> seen;
+        for (size_t start = 0; start < line.size(); start += charLength(line[start]))
+        {
+            size_t end = start;
+            for (size_t chars = 1; chars <= kMaxChars && end < line.size(); chars++)
+            {
+                end = std::min(line.size(), end + charLength(line[end]));
+                if (chars >= kMinChars && end - start >= kMinBytes)
+                {
+                    seen.insert(line.substr(start, end - start));
+                }
+            }
+        }
+        for (const std::string &s : seen)
+        {
+            frequency[s]++;
+        }
+    }
+
+    std::vector<Candidate> candidates;
+    for (const auto &kv : frequency)
+    {
+        if (kv.second >= 2)
+        {
+            candidates.push_back({kv.first, (kv.second - 1) * kv.first.size()});
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+        return a.score != b.score ? a.score > b.score : a.text < b.text;
+    });
+
+    // 贪心选取
+    std::vector<std::string> chosen;
+    size_t size = 0;
+    for (const Candidate &c : candidates)
+    {
+        if (size + c.text.size() > budget || overlaps(c.text, chosen))
+        {
+            continue;
+        }
+        chosen.push_back(c.text);
+        size += c.text.size();
+    }
+
+    std::printf("#pragma once\n\n");
+    std::printf("#include <cstdint>\n#include <string_view>\n\n");
+    std::printf("// 记录压缩用的预置字典, 由 tools/train_dict 根据 %zu 条样本生成, 不要手工修改\n", samples);
+    std::printf("// 已压缩的记录依赖字典内容, 重新训练时须同时递增 RECORD_DICT_ID 并保留旧字典用于解压\n");
+    std::printf("inline constexpr uint8_t RECORD_DICT_ID = 1;\n");
+    std::printf("inline constexpr std::string_view RECORD_DICT =\n");
+    for (size_t i = chosen.size(); i-- > 0;)
+    {
+        std::printf("    \"%s\"%s\n", escape(chosen[i]).c_str(), i == 0 ? ";" : "");
+    }
+    return 0;
+}